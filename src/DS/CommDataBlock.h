@@ -13,6 +13,7 @@
 #include <mpi.h>
 #include "LPT_LogOutput.h"
 #include "PMlibWrapper.h"
+#include "LPT_PositionType.h"
 
 namespace DSlib
 {
@@ -21,10 +22,11 @@ struct CommDataBlockHeader
 {
     long BlockID;
     int SubDomainID;
-    REAL_TYPE Origin[3];
+    POSITION_TYPE Origin[3];
     int OriginCell[3];
     int BlockSize[3];
     REAL_TYPE Pitch[3];
+    int NumTimeLevels;
 };
 
 //! @brief データブロックのヘッダ部をまとめた構造体とデータ領域ヘのポインタ、それぞれの転送用MPI_Request変数をまとめて保持するクラス
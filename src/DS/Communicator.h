@@ -14,6 +14,7 @@
 #include <vector>
 #include <deque>
 #include <list>
+#include <set>
 #include <mpi.h>
 
 #include "CommDataBlock.h"
@@ -35,7 +36,8 @@ public:
     // Constructor
     Communicator(const int& argMaxRequestSize, const int& argMaxDataBlockSize) :
         MaxRequestSize(argMaxRequestSize),
-        MaxDataBlockSize(argMaxDataBlockSize)
+        MaxDataBlockSize(argMaxDataBlockSize),
+        NumSentBlocks(0)
     {
         int NumProcs = LPT::MPI_Manager::GetInstance()->get_nproc_p();
         //TODO MPI_Type_structを使ってヘッダ+DataBlockという形式にする
@@ -81,14 +83,41 @@ public:
     //! @brief *Dataが示す領域に保持されているデータから、BlockIDに相当するブロックのデータを取り出して、SendBuffにパッキングする
     //! @param BlockID  [in]  必要な領域のブロックID
     //! @param Data     [in]  流体ソルバーからもらってきた物理量を格納しているデータ領域へのポインタ
+    //! @param DataPrev [in]  1つ前の時刻の物理量を格納しているデータ領域へのポインタ (NULLの時は1時刻分のみパッキングする)
     //! @param Mask     [in]  流体ソルバーからもらってきた物理量のマスク(物理量が存在しないセルは0他は1)
     //! @param vlen     [in]  Dataの領域に格納されている物理量のベクトル長
-    //! @param SendBuff [out] 送信バッファ
+    //! @param SendBuff [out] 送信バッファ DataPrevを渡した時はDataの後ろにDataPrevのデータを続けて格納する
     //! @param SendSize [out] 送信サイズ
-    void CommPacking(const long& BlockID, REAL_TYPE* Data, int* Mask, const int& vlen, REAL_TYPE* SendBuff, CommDataBlockHeader* Header, int* SendSize);
+    void CommPacking(const long& BlockID, REAL_TYPE* Data, REAL_TYPE* DataPrev, int* Mask, const int& vlen, REAL_TYPE* SendBuff, CommDataBlockHeader* Header, int* SendSize);
 
     //! 要求されたデータブロックを送信しつつRequestIDの受付領域を初期化する
-    void SendDataBlock(REAL_TYPE* Data, int* Mask, const int& vlen, std::list<CommDataBlockManager*>* SendBuff);
+    void SendDataBlock(REAL_TYPE* Data, int* Mask, const int& vlen, std::list<CommDataBlockManager*>* SendBuff)
+    {
+        SendDataBlock(Data, NULL, Mask, vlen, SendBuff);
+    }
+
+    //! @brief 要求されたデータブロックを2時刻分まとめて送信しつつRequestIDの受付領域を初期化する
+    //! @param DataPrev [in] 1つ前の時刻の物理量 (NULLの時は1時刻分のみ送信する)
+    //! 受信側のMaxDataBlockSizeは2時刻分(2*vlen)のサイズで確保されていること
+    void SendDataBlock(REAL_TYPE* Data, REAL_TYPE* DataPrev, int* Mask, const int& vlen, std::list<CommDataBlockManager*>* SendBuff);
+
+    //! @brief 前回ClearSendStats()を呼んでから送信したデータブロックの総数と、そのうち異なるブロックIDの数を返す
+    //!
+    //! 複数の粒子プロセスから同じブロックが要求された場合は、総数には要求された回数分が加算される
+    //! @param NumSent     [out] 送信したデータブロックの総数
+    //! @param NumDistinct [out] 送信したデータブロックのうち異なるブロックIDの数
+    void GetSendStats(long* NumSent, long* NumDistinct)
+    {
+        *NumSent     = NumSentBlocks;
+        *NumDistinct = SentBlockIDs.size();
+    }
+
+    //! 送信したデータブロックの統計情報をクリアする
+    void ClearSendStats(void)
+    {
+        NumSentBlocks = 0;
+        SentBlockIDs.clear();
+    }
 
 private:
     MPI_Datatype MPI_DataBlockHeader; //!< DataBlockのヘッダデータ送受信用データタイプ
@@ -97,6 +126,8 @@ private:
     size_t       MaxRequestSize;      //!< 1プロセスから同時に受け付ける最大ブロックID数
     int MaxDataBlockSize;             //!< 最も大きいデータブロックに含まれるセル数(袖領域も含む)
     MPI_Win      window;              //!< ブロックIDの転送領域用MPI_Win変数
+    long           NumSentBlocks;     //!< 送信したデータブロックの総数
+    std::set<long> SentBlockIDs;      //!< 送信したデータブロックのID
 };
 } // namespace DSlib
 #endif
\ No newline at end of file
@@ -37,7 +37,7 @@ class DSlib
 
 private:
     //Singletonパターンを適用
-    DSlib(){}
+    DSlib() : CellStride(0){}
     DSlib(const DSlib& obj);
     DSlib& operator=(const DSlib& obj);
     ~DSlib()
@@ -67,6 +67,13 @@ public:
         omp_init_lock(&CachedBlocksLock);
     }
 
+    //! @brief キャッシュに登録するデータブロックの流速データの形式を設定する
+    //! @param argCellStride [in] 0の時は受信した形式(成分毎)のまま、3または4の時はその要素数でセル毎にxyz成分を並べた形式に変換する
+    void SetCellStride(const int& argCellStride)
+    {
+        CellStride = argCellStride;
+    }
+
 public:
     //! 最大num_entry個のキャッシュ領域を空ける
     void DiscardCacheEntry2(const long& num_entry);
@@ -89,6 +96,19 @@ public:
     //! CachedBlocksのエントリを登録する
     long AddCachedBlocks(CommDataBlockManager* RecvData, const double& Time);
 
+    //! @brief 受信したデータからDataBlockを生成する
+    //!
+    //! キャッシュへの登録およびインターリーブ形式への変換は行なわないので、AddLocalCachedBlock()で登録すること
+    DataBlock* ReceiveDataBlock(CommDataBlockManager* RecvData, const double& Time);
+
+    //! @brief ReceiveDataBlock()で生成したデータブロックを、呼び出したスレッドが確保した領域に移してからCachedBlocksに登録する
+    //!
+    //! データブロックを計算するスレッドから呼び出すことで、流速データをそのスレッドのNUMAノードに配置する
+    //! 登録と同時にRequestedBlocksからも削除するので、DeleteRequestedBlocks()は呼ばなくて良い
+    //! キャッシュが溢れた時はデータブロックを破棄して-1を返す
+    //! @return 登録したデータブロックのID
+    long AddLocalCachedBlock(DataBlock* Block);
+
     //!  RequestQueuesにブロックIDを登録する
     void AddRequestQueues(const int& SubDomainID, const long& BlockID);
 
@@ -102,10 +122,12 @@ public:
 
     //! RequestedBlocksからブロックIDを削除する
     //
-    //このルーチンはLPT_CalcParticleData()のSingleスレッド区間からしか呼ばれないので、非スレッドセーフな処理だがロックしていない
+    //粒子計算中の他のスレッドがLoad()で参照するので、CachedBlocksLockを取ってから削除する
     void DeleteRequestedBlocks(const long BlockID)
     {
+        omp_set_lock(&CachedBlocksLock);
         int num_removed = RequestedBlocks.erase(BlockID);
+        omp_unset_lock(&CachedBlocksLock);
         if(num_removed != 1)
         {
             LPT::LPT_LOG::GetInstance()->ERROR("remove key from RequestedBlocks failed: ", BlockID);
@@ -137,6 +159,7 @@ private:
     std::set<long> RequestedBlocks;                   //!< データ転送を要求したブロックIDのリスト
     std::CACHE_CONTAINER<Cache*> CachedBlocks;        //!< データブロックのキャッシュ
     int CacheSize;                                    //!< CachedBlocksに登録できるブロック数
+    int CellStride;                                   //!< キャッシュに登録する時に変換するインターリーブ形式の1セルあたりの要素数 (0の時は変換しない)
 };
 } // namespace DSlib
 #endif
\ No newline at end of file
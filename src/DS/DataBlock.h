@@ -10,6 +10,7 @@
 #ifndef DSLIB_DATA_BLOCK_H
 #define DSLIB_DATA_BLOCK_H
 #include <iostream>
+#include "LPT_PositionType.h"
 
 namespace DSlib
 {
@@ -19,16 +20,20 @@ struct DataBlock
 public:
     long BlockID;              //!< データブロックのID
     int SubDomainID;           //!< そのデータブロックが存在するサブドメインのID
-    REAL_TYPE Origin[3];       //!< データブロックの原点座標
+    POSITION_TYPE Origin[3];   //!< データブロックの原点座標
     int OriginCell[3];         //!< データブロックの原点位置を含むセルのindex
     int BlockSize[3];          //!<  このデータブロックのサイズ(単位はセル数)
     double Time;               //!<  このデータブロックが保持する流速場の情報が、どの時刻のものなのかを保持する
     REAL_TYPE Pitch[3];        //!<  セル幅
+    int CellStride;            //!<  インターリーブ形式の時の1セルあたりの要素数(3または4) 成分毎に並んだ形式の時は0
+    long Stride[3];            //!<  インターリーブ形式の時のi,j,k方向のストライド(単位は要素数)
     //TODO ここまでを内部クラスにまとめる
     REAL_TYPE* Data;           //!<  流速データの配列へのポインタ
+    REAL_TYPE* DataPrev;       //!<  1つ前の時刻(Time-deltaT)の流速データの配列へのポインタ 時間補間を行なわない時はNULL
+                               //!<  Dataと同じ領域の後半を指しているので個別に解放してはならない
 
     //! コンストラクタ
-    DataBlock() : Data(NULL), BlockID(-1), SubDomainID(-1), Time(-1.0)
+    DataBlock() : BlockID(-1), SubDomainID(-1), Time(-1.0), CellStride(0), Data(NULL), DataPrev(NULL)
     {
         OriginCell[0] = -1;
         OriginCell[1] = -1;
@@ -36,6 +41,9 @@ public:
         BlockSize[0]  = -1;
         BlockSize[1]  = -1;
         BlockSize[2]  = -1;
+        Stride[0]     = 0;
+        Stride[1]     = 0;
+        Stride[2]     = 0;
         //TODO OriginとpitchはNanで初期化したい
     }
 
@@ -56,9 +64,12 @@ public:
             OriginCell[i] = arg.OriginCell[i];
             BlockSize[i]  = arg.BlockSize[i];
             Pitch[i]      = arg.Pitch[i];
+            Stride[i]     = arg.Stride[i];
         }
-        Data = arg.Data;
-        Time = arg.Time;
+        Data       = arg.Data;
+        DataPrev   = arg.DataPrev;
+        CellStride = arg.CellStride;
+        Time       = arg.Time;
     }
 
     //! 代入オペレータ
@@ -72,12 +83,28 @@ public:
             OriginCell[i] = arg.OriginCell[i];
             BlockSize[i]  = arg.BlockSize[i];
             Pitch[i]      = arg.Pitch[i];
+            Stride[i]     = arg.Stride[i];
         }
-        Data = arg.Data;
-        Time = arg.Time;
+        Data       = arg.Data;
+        DataPrev   = arg.DataPrev;
+        CellStride = arg.CellStride;
+        Time       = arg.Time;
         return *this;
     }
 
+    //! @brief 流速データを成分毎に並んだ形式から、セル毎にxyz成分が並んだインターリーブ形式に変換する
+    //!
+    //! DataPrevがNULLで無い時は、DataPrevも同じ形式に変換して新しい領域の後半に格納する
+    //! @param arg_CellStride [in] 1セルあたりの要素数 (3または4 4の時は最後の要素を0で埋める)
+    void ConvertToInterleaved(const int& arg_CellStride);
+
+    //! @brief 流速データを呼び出したスレッドが確保した領域にコピーし直す
+    //!
+    //! first touchで、流速データのページを呼び出したスレッドのNUMAノードに配置するためのもの
+    //! arg_CellStrideが正で、まだ変換していない時はコピーの代わりにConvertToInterleaved()を行なう
+    //! @param arg_CellStride [in] キャッシュに登録する時に変換するインターリーブ形式の1セルあたりの要素数 (0の時は変換しない)
+    void MoveToLocalMemory(const int& arg_CellStride);
+
     //!  挿入子オーバーロード
     friend std::ostream& operator<<(std::ostream& stream, DataBlock obj);
 };
@@ -14,6 +14,7 @@
 #include <vector>
 #include <set>
 #include "LPT_LogOutput.h"
+#include "LPT_PositionType.h"
 
 namespace DSlib
 {
@@ -23,11 +24,15 @@ class CommDataBlockHeader;
 //! @brief サブドメインおよびデータブロックの分割情報を保持するクラス
 //!
 //! BlockIDおよびSubDomainIDは1次元のアドレスだが、このクラス内部では3次元のアドレスとして扱い、取り出す時に3Dto1Dの変換を行なう
+//! BlockIDはx方向が最も速く変わる辞書順の通し番号か、ブロックの3次元indexのビットを交互に並べたMorton順の番号のどちらかで
+//! BlockIDを生成/分解する処理は全てEncodeBlockID()/DecodeBlockID()を通して行なう
 class DecompositionManager
 {
     DecompositionManager()
     {
         initialized = false;
+        MortonOrder = false;
+        NumBlockIDs = 0;
     }
 
     DecompositionManager(const DecompositionManager& obj);
@@ -85,7 +90,35 @@ public:
     }
 
     //! @brief Nx,Ny,Nz,NPx,NPy,NPz,NBx,NBy,NBzの値を元に、{Block,SubDomain}Boundary? の値を設定する
-    void Initialize(const REAL_TYPE& arg_Nx, const REAL_TYPE& arg_Ny, const REAL_TYPE& arg_Nz, const REAL_TYPE& arg_NPx, const REAL_TYPE& arg_NPy, const REAL_TYPE& arg_NPz, const REAL_TYPE& arg_NBx, const REAL_TYPE& arg_NBy, const REAL_TYPE& arg_NBz, const REAL_TYPE& arg_OriginX, const REAL_TYPE& arg_OriginY, const REAL_TYPE& arg_OriginZ, const REAL_TYPE& arg_dx, const REAL_TYPE& arg_dy, const REAL_TYPE& arg_dz, const int& arg_GuideCellSize);
+    //! @param arg_MortonOrder [in] BlockIDをMorton順で付番するかどうかのフラグ
+    void Initialize(const REAL_TYPE& arg_Nx, const REAL_TYPE& arg_Ny, const REAL_TYPE& arg_Nz, const REAL_TYPE& arg_NPx, const REAL_TYPE& arg_NPy, const REAL_TYPE& arg_NPz, const REAL_TYPE& arg_NBx, const REAL_TYPE& arg_NBy, const REAL_TYPE& arg_NBz, const POSITION_TYPE& arg_OriginX, const POSITION_TYPE& arg_OriginY, const POSITION_TYPE& arg_OriginZ, const POSITION_TYPE& arg_dx, const POSITION_TYPE& arg_dy, const POSITION_TYPE& arg_dz, const int& arg_GuideCellSize, const bool& arg_MortonOrder = false);
+
+    //! @brief ブロックの3次元indexからBlockIDを求める
+    //!
+    //! Morton順の時は、軸毎に事前に計算したビットの配置を表引きしてORを取るだけなので
+    //! 辞書順の時と同程度のコストで変換できる
+    long EncodeBlockID(const int& i, const int& j, const int& k) const
+    {
+        if(MortonOrder)
+        {
+            return MortonCodeX[i]|MortonCodeY[j]|MortonCodeZ[k];
+        }
+        return Convert3Dto1Dlong<long>(i, j, k, NBx*NPx, NBy*NPy);
+    }
+
+    //! @brief BlockIDからブロックの3次元indexを求める
+    void DecodeBlockID(const long& BlockID, int* BlockID3D) const
+    {
+        BlockID3D[0] = GetBlockIDX(BlockID);
+        BlockID3D[1] = GetBlockIDY(BlockID);
+        BlockID3D[2] = GetBlockIDZ(BlockID);
+    }
+
+    //! BlockIDがMorton順で付番されているかどうかを返す
+    bool isMortonOrder(void) const
+    {
+        return MortonOrder;
+    }
 
     //! @brief 与えられたブロックIDの場所の流体計算を担当するプロセスのRank番号(=subdomain ID)を返す
     //! @param id [in] サブドメインIDを探したいデータブロックのID
@@ -95,20 +128,20 @@ public:
     //! @brief 与えられた座標を含むデータブロックのIDを返す(線形探索版)
     //! @param Coord [in] 座標
     //! @retval 引数で渡した座標を含むデータブロックのID
-    long FindBlockIDByCoordLinear(REAL_TYPE Coord[3]);
-    long FindBlockIDByCoordLinear(const REAL_TYPE& x, const REAL_TYPE& y, const REAL_TYPE& z)
+    long FindBlockIDByCoordLinear(POSITION_TYPE Coord[3]);
+    long FindBlockIDByCoordLinear(const POSITION_TYPE& x, const POSITION_TYPE& y, const POSITION_TYPE& z)
     {
-        REAL_TYPE Coord[3] = {x, y, z};
+        POSITION_TYPE Coord[3] = {x, y, z};
         return FindBlockIDByCoordLinear(Coord);
     }
 
     //! @brief 与えられた座標を含むデータブロックのIDを返す(二分探索版)
     //! @param Coord [in] 座標
     //! @retval 引数で渡した座標を含むデータブロックのID
-    long FindBlockIDByCoordBinary(REAL_TYPE Coord[3]);
-    long FindBlockIDByCoordBinary(const REAL_TYPE& x, const REAL_TYPE& y, const REAL_TYPE& z)
+    long FindBlockIDByCoordBinary(POSITION_TYPE Coord[3]);
+    long FindBlockIDByCoordBinary(const POSITION_TYPE& x, const POSITION_TYPE& y, const POSITION_TYPE& z)
     {
-        REAL_TYPE Coord[3] = {x, y, z};
+        POSITION_TYPE Coord[3] = {x, y, z};
         return FindBlockIDByCoordBinary(Coord);
     }
 
@@ -119,24 +152,39 @@ public:
 
     //! @brief 引数で渡された座標が解析領域外に出ていないか判定する
     //! CheckBound{X,Y,Z}の戻り値を加算して返すので、戻り値の意味はそちらを参照のこと
-    int CheckBounds(REAL_TYPE Coord[3]);
+    int CheckBounds(POSITION_TYPE Coord[3]);
 
     //! Accessor
-    REAL_TYPE Getdx()
+    POSITION_TYPE Getdx()
     {
         return this->dx;
     }
 
-    REAL_TYPE Getdy()
+    POSITION_TYPE Getdy()
     {
         return this->dy;
     }
 
-    REAL_TYPE Getdz()
+    POSITION_TYPE Getdz()
     {
         return this->dz;
     }
 
+    //! @brief BlockIDの取り得る値の上限(最大値+1)を返す
+    //!
+    //! Morton順の時は各軸のブロック数を2のべき乗に切り上げた値の積になるので、
+    //! ブロックが存在しないBlockIDも含まれることに注意
+    long GetNumBlockIDs()
+    {
+        return NumBlockIDs;
+    }
+
+    //! @brief BlockIDの付番方法を表すハッシュ値を返す
+    //!
+    //! ブロック境界の座標と付番の順序から計算するので、この値が等しければ同じ座標に同じBlockIDが付く
+    //! チェックポイントに保存したBlockIDをそのまま使えるかどうかの判定に用いる
+    unsigned long GetBlockIDSignature(void) const;
+
     int GetLargestBlockSize()
     {
         return this->LargestBlockSize;
@@ -162,17 +210,17 @@ public:
         return BlockBoundaryZ[GetBlockIDZ(BlockID)];
     }
 
-    REAL_TYPE GetBlockOriginX(const long& BlockID)
+    POSITION_TYPE GetBlockOriginX(const long& BlockID)
     {
         return OriginX+BlockBoundaryX[GetBlockIDX(BlockID)]*dx;
     }
 
-    REAL_TYPE GetBlockOriginY(const long& BlockID)
+    POSITION_TYPE GetBlockOriginY(const long& BlockID)
     {
         return OriginY+BlockBoundaryY[GetBlockIDY(BlockID)]*dy;
     }
 
-    REAL_TYPE GetBlockOriginZ(const long& BlockID)
+    POSITION_TYPE GetBlockOriginZ(const long& BlockID)
     {
         return OriginZ+BlockBoundaryZ[GetBlockIDZ(BlockID)]*dz;
     }
@@ -242,9 +290,9 @@ private:
                                                //!< ブロックIDはサブドメインをまたいだ通し番号となっていることに注意
     int* BlockBoundaryY;                       //!< BlockBoundaryXと同様
     int* BlockBoundaryZ;                       //!< BlockBoundaryXと同様
-    std::vector<REAL_TYPE> RealBlockBoundaryX; //!< x軸方向のデータブロック分割の境目になる座標を保持する
-    std::vector<REAL_TYPE> RealBlockBoundaryY; //!< RealBlockBoundaryXと同様
-    std::vector<REAL_TYPE> RealBlockBoundaryZ; //!< RealBlockBoundaryXと同様
+    std::vector<POSITION_TYPE> RealBlockBoundaryX; //!< x軸方向のデータブロック分割の境目になる座標を保持する
+    std::vector<POSITION_TYPE> RealBlockBoundaryY; //!< RealBlockBoundaryXと同様
+    std::vector<POSITION_TYPE> RealBlockBoundaryZ; //!< RealBlockBoundaryXと同様
     int Nx;                                    //!< 計算領域のx方向のサイズ 単位はセル数
     int Ny;                                    //!< 計算領域のy方向のサイズ 単位はセル数
     int Nz;                                    //!< 計算領域のz方向のサイズ 単位はセル数
@@ -254,15 +302,40 @@ private:
     int NBx;                                   //!< 1サブドメインあたりのx軸方向のデータブロック数
     int NBy;                                   //!< 1サブドメインあたりのx軸方向のデータブロック数
     int NBz;                                   //!< 1サブドメインあたりのx軸方向のデータブロック数
-    REAL_TYPE OriginX;                         //!< 解析領域全体の原点のx座標
-    REAL_TYPE OriginY;                         //!< 解析領域全体の原点のy座標
-    REAL_TYPE OriginZ;                         //!< 解析領域全体の原点のz座標
-    REAL_TYPE dx;                              //!< x方向のセル幅
-    REAL_TYPE dy;                              //!< y方向のセル幅
-    REAL_TYPE dz;                              //!< z方向のセル幅
+    POSITION_TYPE OriginX;                     //!< 解析領域全体の原点のx座標
+    POSITION_TYPE OriginY;                     //!< 解析領域全体の原点のy座標
+    POSITION_TYPE OriginZ;                     //!< 解析領域全体の原点のz座標
+    POSITION_TYPE dx;                          //!< x方向のセル幅
+    POSITION_TYPE dy;                          //!< y方向のセル幅
+    POSITION_TYPE dz;                          //!< z方向のセル幅
     int       LargestBlockSize;                //!< BlockID=0(全ブロック中最も大きいブロック)が持つセル数
     int       GuideCellSize;                   //!< 流体から転送してくる袖領域のサイズx,y,z全方向で+-の両方にGuideCell数分の袖領域があることを示す
     bool      initialized;                     //!< Initialize()が呼ばれたかどうかのフラグ
+    bool      MortonOrder;                     //!< BlockIDをMorton順で付番するかどうかのフラグ
+    long      NumBlockIDs;                     //!< BlockIDの取り得る値の上限(最大値+1)
+    std::vector<long> MortonCodeX;             //!< x方向のブロックindex毎の、Morton符号のうちx方向の成分
+    std::vector<long> MortonCodeY;             //!< MortonCodeXと同様
+    std::vector<long> MortonCodeZ;             //!< MortonCodeXと同様
+    std::vector<int>  MortonBitsX;             //!< x方向のindexの各ビットがMorton符号のどのビットに置かれるか
+    std::vector<int>  MortonBitsY;             //!< MortonBitsXと同様
+    std::vector<int>  MortonBitsZ;             //!< MortonBitsXと同様
+
+    //! @brief 各軸のブロック数からMorton符号のビット配置を決める
+    //!
+    //! 下位ビットから順に、まだビットが残っている軸だけを x,y,z の順に交互に並べる
+    //! 軸毎のブロック数が大きく異なる場合でも、BlockIDの上限は総ブロック数の8倍未満に収まる
+    void InitializeMortonCode();
+
+    //! Morton符号から指定した軸のindexを取り出す
+    static int ExtractMortonBits(const long& Code, const std::vector<int>& Bits)
+    {
+        int Index = 0;
+        for(size_t b = 0; b < Bits.size(); b++)
+        {
+            Index |= static_cast<int>((Code>>Bits[b])&1L)<<b;
+        }
+        return Index;
+    }
 
     //! LengthをNumBlocksで分割し個々の領域のサイズをPartsに先頭から順に格納して返す
     void Decomposer(const int Length, const int NumBlocks, std::vector<int>* Parts);
@@ -277,32 +350,35 @@ private:
     //! @retval   2 X-plus方向に出ている
     //! @retval   1 X-minus方向に出ている
     //! @retval   0 領域内
-    int CheckBoundX(REAL_TYPE XCoord);
+    int CheckBoundX(POSITION_TYPE XCoord);
 
     //! @brief 引数で渡されたy座標が解析領域外に出ていないか判定する
     //! @retval  20 Y-plus方向に出ている
     //! @retval  10 Y-minus方向に出ている
     //! @retval   0 領域内
-    int CheckBoundY(REAL_TYPE YCoord);
+    int CheckBoundY(POSITION_TYPE YCoord);
 
     //! @brief 引数で渡されたz座標が解析領域外に出ていないか判定する
     //! @retval 200 Z-plus方向に出ている
     //! @retval 100 Z-minus方向に出ている
     //! @retval   0 領域内
-    int CheckBoundZ(REAL_TYPE ZCoord);
+    int CheckBoundZ(POSITION_TYPE ZCoord);
 
-    int GetBlockIDX(const long& BlockID)
+    int GetBlockIDX(const long& BlockID) const
     {
+        if(MortonOrder)return ExtractMortonBits(BlockID, MortonBitsX);
         return (BlockID%(NBx*NPx*NBy*NPy))%(NBx*NPx);
     }
 
-    int GetBlockIDY(const long& BlockID)
+    int GetBlockIDY(const long& BlockID) const
     {
+        if(MortonOrder)return ExtractMortonBits(BlockID, MortonBitsY);
         return (BlockID%(NBx*NPx*NBy*NPy))/(NBx*NPx);
     }
 
-    int GetBlockIDZ(const long& BlockID)
+    int GetBlockIDZ(const long& BlockID) const
     {
+        if(MortonOrder)return ExtractMortonBits(BlockID, MortonBitsZ);
         return BlockID/(NBx*NPx*NBy*NPy);
     }
 
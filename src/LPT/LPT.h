@@ -13,9 +13,11 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <map>
 #include <string>
 #include <mpi.h>
 #include "LPT_Args.h"
+#include "ParticleOutputFilter.h"
 
 //forward declaration
 namespace DSlib
@@ -31,6 +33,7 @@ class PPlib;
 class ParticleData;
 class StartPoint;
 class PP_Transport;
+class SuspendedParticles;
 }
 namespace pm_lib
 {
@@ -39,6 +42,12 @@ class PerfMonitor;
 
 namespace LPT
 {
+//forward declaration
+class TransportScheduler;
+struct TransportWork;
+class ParticleWriter;
+class AsyncParticleWriter;
+
 //! @brief LPTのインターフェースルーチンを提供するクラス
 //!
 //! 計算に必要なパラメータ、他クラスへのポインタを保持し
@@ -47,7 +56,7 @@ class LPT
 {
 private:
     //Singletonパターンを適用
-    LPT() : initialized(false)
+    LPT() : initialized(false), ptrWriter(NULL), ptrUserWriter(NULL), ptrAsyncWriter(NULL), LastOutputBytes(0), ptrScheduler(NULL)
     {
         NumPolling   = 10000;
         PollingRatio = 0.8;
@@ -88,6 +97,25 @@ private:
     REAL_TYPE RefLength;                          //!< 代表長さ
     REAL_TYPE RefVelocity;                        //!< 代表速度
     bool      OutputDimensional;                  //!<ファイル出力を有次元で行うかどうかのフラグ
+    ParticleWriter* ptrWriter;                    //!< 粒子データの出力先 (LPT_InitializeArgsの指定に従って生成する)
+    ParticleWriter* ptrUserWriter;                //!< LPT_SetParticleWriter()で設定された粒子データの出力先 (NULLの時はptrWriterを使う)
+    AsyncParticleWriter* ptrAsyncWriter;          //!< バックグラウンドで出力する時に使うWriter (非同期出力が無効な時はNULL)
+    int       OutputChunkSize;                    //!< 粒子データの出力時に1度に収集する粒子数
+    ParticleOutputFilter OutputFilter;            //!< 粒子データの出力対象を絞り込む条件
+    size_t    LastOutputBytes;                    //!< 直前のLPT_OutputParticleData()でこのプロセスが出力したデータ量(byte)
+    std::string CheckpointFileName;               //!< チェックポイントファイルのベースファイル名
+
+    int   MigrationInterval;                      //!< マイグレーションの判定を行なうタイムステップ間隔
+    float MigrationThreshold;                     //!< マイグレーションを行なう負荷の不均衡度(最大値/平均値)の閾値
+    int   MaxParticlesPerProc;                    //!< 稼働中の粒子計算プロセスを増やす平均粒子数の閾値
+    bool  BatchedTransport;                       //!< ブロック内の粒子をまとめて計算するかどうかのフラグ
+    bool  BlockOwnership;                         //!< 粒子計算プロセスがBlockIDの範囲毎に粒子を担当するかどうかのフラグ
+    bool  AdaptiveTimeStep;                       //!< 粒子毎にサブステップ数を決めるかどうかのフラグ
+    double CourantNumber;                         //!< 1サブステップで粒子が移動するセル数の上限
+    bool  TemporalInterpolation;                  //!< 2時刻分の流速で時間方向にも補間するかどうかのフラグ
+    TransportScheduler* ptrScheduler;             //!< 粒子計算のスケジューラへのポインタ (WorkStealingSchedulerが無効な時はNULL)
+    int   NumaDomains;                            //!< 1プロセスあたりのNUMAドメイン数
+    int   MortonSortThreshold;                    //!< 粒子をMorton順に並べ替えるブロック内の最小粒子数 (0以下の時は並べ替えない)
 
     MPI_Win   window_for_rerun_flag;                       //!< データブロックの再送フラグを通信するためのwindows
     bool      work_for_rerun_flag;                         //!< データブロックの再送フラグを通信するためのワーク領域(粒子プロセスのrank0のみが使用)
@@ -110,6 +138,47 @@ public:
     //! プロセス毎に異なるファイルに出力する
     int LPT_OutputParticleData(const int& TimeStep, const double& Time, float* v00);
 
+    //! @brief LPT_OutputParticleData()の出力先を設定する
+    //!
+    //! 粒子データは固定長のチャンク毎にWriter->Write()に渡される
+    //! Writerの破棄は呼び出し側で行なうこと。NULLを渡すとLPT_InitializeArgsで指定した出力先に戻る
+    //! 非同期出力時は、LPT_WaitParticleOutput()が戻るまで以前のWriterを破棄しないこと
+    void LPT_SetParticleWriter(ParticleWriter* Writer)
+    {
+        ptrUserWriter = Writer;
+    }
+
+    //! @brief LPT_OutputParticleData()で出力する粒子とフィールドを絞り込む条件を設定する
+    //!
+    //! 座標の範囲は無次元の値で指定する
+    //! 出力するフィールドを絞り込んだ場合、そのファイルはリスタートには使えない
+    void LPT_SetOutputFilter(const ParticleOutputFilter& Filter)
+    {
+        OutputFilter = Filter;
+    }
+
+    //! @brief 直前のLPT_OutputParticleData()でこのプロセスが出力したデータ量(byte)を返す
+    //!
+    //! 圧縮やファイルのメタデータを除いた、粒子データ本体の大きさ
+    size_t LPT_GetLastOutputBytes(void) const
+    {
+        return LastOutputBytes;
+    }
+
+    //! @brief バックグラウンドで書き出し中の粒子データがあれば、その終了を待つ
+    //!
+    //! 非同期出力が無効な時は何もせずに0を返す
+    //! @retval 0 前回の呼び出し以降にバックグラウンドで行なった出力が全て正常に終了した
+    int LPT_WaitParticleOutput(void);
+
+    //! @brief リスタート用のチェックポイントファイルを出力する
+    //!
+    //! 粒子計算プロセス毎に、保持している粒子と開始点を無次元のまま LPT_InitializeArgs::CheckpointFileName+"_rank番号_タイムステップ.lptc" に出力する
+    //! LPT_InitializeArgs::CheckpointRestartを有効にしてTimeStepをCurrentTimeStepに指定すると、このファイルからリスタートする
+    //! リスタート時の粒子計算プロセス数が出力時と異なる場合は、全ファイルを分担して読み込み、粒子と開始点を分配し直す
+    //! @retval 0 正常終了
+    int LPT_WriteCheckpoint(const int& TimeStep, const double& Time);
+
     //! 粒子データを出力し、LPTの内部で保持している全ての開始点, 粒子, 流速データを破棄する
     int LPT_Post(void);
 
@@ -121,6 +190,14 @@ public:
     bool LPT_SetStartPointCuboid(REAL_TYPE Coord1[3], REAL_TYPE Coord2[3], int NumStartPoints[3], double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
     bool LPT_SetStartPointCircle(REAL_TYPE Coord1[3], int SumStartPoints, REAL_TYPE Radius, REAL_TYPE NormalVector[3], double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
 
+    //! @brief 放出時刻と寿命が共通の多数の点を1つの開始点として登録する
+    //!
+    //! 点毎にLPT_SetStartPoint()を呼んだ場合と同じ粒子を放出するが、開始点オブジェクトは1つだけ生成し
+    //! 開始点の分散時はPointSet::Divider()で点の並び順に分割する
+    //! @param NumPoints [in] 点の数
+    //! @param Coords    [in] 点の座標 (x, y, zの順に3*NumPoints要素)
+    bool LPT_SetStartPoints(const int& NumPoints, REAL_TYPE* Coords, double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
+
     //! MPI_Testによるポーリング回数を取得
     int GetNumPolling()
     {
@@ -146,16 +223,70 @@ public:
     }
 
 private:
+    //! @brief 可視化用の粒子データの出力に使うPDMlibを初期化する
+    //! @param args     [in] LPT_Initialize()の引数
+    //! @param Continue [in] trueの時は既存のdfiファイルからコンテナの情報を読み込み、その続きとして出力する
+    void InitializePDMlib(const LPT_InitializeArgs& args, const bool& Continue);
+
+    //! @brief チェックポイントファイルから自Rankが担当していた開始点と粒子を読み込む
+    //!
+    //! 保存時と粒子計算プロセス数が異なる場合はReadCheckpointWithRedistribution()で読み込む
+    //! BlockIDの付番が保存時と同じ場合は、保存されたBlockIDのまま粒子をブロック単位でコンテナに登録する
+    //! @retval 0 正常終了
+    int ReadCheckpoint(const LPT_InitializeArgs& args);
+
+    //! @brief 全てのチェックポイントファイルを読み込み、粒子と開始点を現在の粒子計算プロセスに分配し直す
+    //!
+    //! 保存時と粒子計算プロセス数が異なる場合か、LPT_InitializeArgs::MigrateOnRestartが指定された場合に用いる
+    //! 各Rankは全粒子を通し番号で等分した範囲だけをファイルから読み込み、PPlib::DistributeParticles()で稼働中のプロセスへ送る
+    //! 開始点はPPlib::ReassignStartPoints()で分割せずに割り当て直す
+    //! @param NumFiles       [in] 保存時の粒子計算プロセス数(ファイル数)
+    //! @param NumActiveFiles [in] 保存時の稼働中の粒子計算プロセス数
+    //! @retval 0 正常終了
+    int ReadCheckpointWithRedistribution(const LPT_InitializeArgs& args, const int& NumFiles, const int& NumActiveFiles);
+
     //! 送受信バッファの管理に使っていたCommDataBlockManagerのオブジェクトを削除する
     //
     //オブジェクトが保持する個々の領域はデストラクタ内でdeleteされる
     inline void DeleteCommBuff(std::list<DSlib::CommDataBlockManager*>* SendBuff, std::list<DSlib::CommDataBlockManager*>* RecvBuff);
 
-    //! PPlib::Particlesに含まれる全ての粒子移動を再計算する
-    inline void ReCalcParticlesAll(PPlib::PP_Transport& Transport, const double& deltaT, const int& divT, const double& CurrentTime, const int& CurrentTimeStep);
+    //! 指定したlistに含まれる粒子の移動を計算する
+    //
+    //! 計算後も同じブロックに留まった粒子のlistはcalcedに、他のブロックへ移動した粒子は移動後のBlockID毎にmovedに追加し
+    //! 未着のブロックへ移動して計算を中断した粒子はSuspendedに登録する
+    //! 渡されたlistはこの関数内でcalcedに追加するかdeleteするので、呼び出し側で参照、deleteしてはならない
+    //! @return 計算した粒子数
+    inline long TransportParticles(PPlib::PP_Transport& Transport, std::list<PPlib::ParticleData*>* work, PPlib::SuspendedParticles& Suspended, std::vector<std::list<PPlib::ParticleData*>*>& calced, std::map<long, std::list<PPlib::ParticleData*>*>& moved, const LPT_CalcArgs& args);
+
+    //! 粒子オブジェクトを呼び出したスレッドで確保し直す
+    //
+    //! first touchで、粒子データを計算するスレッドのNUMAノードに配置するためのもの
+    //! list内の順序は変わらない
+    inline void RelocateParticles(std::list<PPlib::ParticleData*>* Particles);
+
+    //! スケジューラから取り出した作業単位を計算し、計算時間と計算した粒子数を集計する
+    //
+    //! 準備用の作業単位の時は、データブロックと粒子を自スレッドの領域に移してキャッシュに登録し、作業単位に分割して登録し直す
+    inline void CalcTransportWork(PPlib::PP_Transport& Transport, const TransportWork& Work, PPlib::SuspendedParticles& Suspended, std::vector<std::list<PPlib::ParticleData*>*>& calced, std::map<long, std::list<PPlib::ParticleData*>*>& moved, const LPT_CalcArgs& args, double* TransportTime, long* NumTransported, long* NumAdvanced, long* NumSubSteps);
+
+    //! 指定したデータブロックで再開する粒子の計算を再開する
+    //
+    //! 計算を終えた粒子は移動後のBlockID毎にmovedに追加し、再び中断した粒子はSuspendedに戻す
+    //! @return 計算を再開した粒子数
+    inline long ResumeSuspendedParticles(PPlib::PP_Transport& Transport, PPlib::SuspendedParticles& Suspended, const long& BlockID, std::map<long, std::list<PPlib::ParticleData*>*>& moved, const double& CurrentTime, const int& CurrentTimeStep);
+
+    //! 再開先のデータブロックがキャッシュにある中断中の粒子を、再開できる粒子が無くなるまで計算する
+    //
+    //! データブロック到着時のタスクが再開先のブロックの処理を終えた後に中断した粒子が対象
+    //! 再開先のブロック単位でスレッド並列に計算し、計算を終えた粒子はスレッド毎のmovedに追加する
+    //! 計算時間(全スレッドの合計)、移動計算を終えた粒子数、サブステップ数はそれぞれ引数の値に加算する
+    inline void ResumeArrivedParticles(PPlib::PP_Transport& Transport, PPlib::SuspendedParticles& Suspended, std::vector<std::map<long, std::list<PPlib::ParticleData*>*> >& moved, const double& CurrentTime, const int& CurrentTimeStep, double* TransportTime, long* NumAdvanced, long* NumSubSteps);
 
     //! 計算済の粒子をPPlib::Particlesに戻す
-    inline void MoveBackToParticleContainer(std::vector<std::list<PPlib::ParticleData*>*>& calced, std::vector<PPlib::ParticleData*>& moved);
+    //
+    //! calced, movedはスレッド毎に用意した一時バッファで、スレッド毎に並列にParticleContainerへ戻す
+    //! movedは移動先のBlockID毎にlistにまとめてあるので、ロックを取る回数はブロック数程度になる
+    inline void MoveBackToParticleContainer(std::vector<std::vector<std::list<PPlib::ParticleData*>*> >& calced, std::vector<std::map<long, std::list<PPlib::ParticleData*>*> >& moved);
 
     //! 指定したデータブロックの到着を確認
     bool is_arrived(DSlib::CommDataBlockManager* RecvBuffManager, const int& polling_counter);
@@ -10,6 +10,9 @@
 #ifndef LPT_LPT_ARGS_H
 #define LPT_LPT_ARGS_H
 
+#include "PP_IntegratorType.h"
+#include "LPT_PositionType.h"
+
 namespace LPT
 {
 //! LPT_Initialize()の引数を保持する構造体
@@ -25,12 +28,12 @@ struct LPT_InitializeArgs
     int NBx;                   //!< 1サブドメインあたりのx軸方向のデータブロック数
     int NBy;                   //!< 1サブドメインあたりのx軸方向のデータブロック数
     int NBz;                   //!< 1サブドメインあたりのx軸方向のデータブロック数
-    REAL_TYPE dx;              //!< x方向のセル幅
-    REAL_TYPE dy;              //!< y方向のセル幅
-    REAL_TYPE dz;              //!< z方向のセル幅
-    REAL_TYPE OriginX;         //!< 原点のX座標
-    REAL_TYPE OriginY;         //!< 原点のY座標
-    REAL_TYPE OriginZ;         //!< 原点のZ座標
+    POSITION_TYPE dx;          //!< x方向のセル幅
+    POSITION_TYPE dy;          //!< y方向のセル幅
+    POSITION_TYPE dz;          //!< z方向のセル幅
+    POSITION_TYPE OriginX;     //!< 原点のX座標
+    POSITION_TYPE OriginY;     //!< 原点のY座標
+    POSITION_TYPE OriginZ;     //!< 原点のZ座標
     int GuideCellSize;         //!< ガイドセル(袖領域)のサイズ
     int* d_bcv;                //!< セルが流体か固体かを示すマスク配列(30bit目のみを使用)
 
@@ -50,23 +53,48 @@ struct LPT_InitializeArgs
     float CurrentTime;         //!< リスタート計算をする時の開始時刻
     int CurrentTimeStep;       //!< リスタート計算をする時の開始タイムステップ (1以上の時はリスタート計算とみなす)
 
-    bool MigrateOnRestart;     //!< リスタートデータの読み込み時にマイグレーションするかどうかのフラグ
-    int MigrationInterval;     //!< マイグレーションの判定を行なうタイムステップ間隔
+    bool MigrateOnRestart;     //!< リスタートデータの読み込み時にマイグレーションするかどうかのフラグ (チェックポイントからのリスタート時はプロセス数が同じでも粒子と開始点を分配し直す)
+    int MigrationInterval;     //!< マイグレーションの判定を行なうタイムステップ間隔 (0以下の時はマイグレーションを行なわない)
+    float MigrationThreshold;  //!< 粒子数または粒子計算時間の最大値/平均値がこの値を越えたらマイグレーションを行なう
+    bool BlockOwnership;       //!< 粒子計算プロセスがBlockIDの範囲毎に粒子を担当するかどうかのフラグ
+    bool MortonBlockID;        //!< BlockIDをブロックの3次元indexのMorton順で付番するかどうかのフラグ (全プロセスでrank0の値を使う)
 
     bool OutputDimensional;    //!< ファイル出力を有次元に換算してから行うかどうかのフラグ
+    bool BinaryParticleOutput; //!< 粒子データをPDMlibではなくプロセス毎のバイナリファイルに逐次出力するかどうかのフラグ
+    int OutputChunkSize;       //!< 粒子データの出力時に1度に収集する粒子数 (0以下の時は全粒子をまとめて収集する)
+                               //!< PDMlibへの出力は全粒子分の領域を確保するので、出力時のメモリ使用量がこの値で抑えられるのはBinaryParticleOutputまたは逐次出力するWriterをLPT_SetParticleWriter()で設定した時だけ
+    bool AsynchronousParticleOutput; //!< 粒子データのスナップショットを取り、ファイルへの書き出しはバックグラウンドスレッドで行なうかどうかのフラグ
+    std::string CheckpointFileName; //!< LPT::LPT_WriteCheckpoint()で出力するチェックポイントファイルのベースファイル名
+    bool CheckpointRestart;         //!< リスタート時にPDMlibの出力ではなくチェックポイントファイルから粒子と開始点を読み込むかどうかのフラグ
     REAL_TYPE RefLength;       //!< 代表長さ
     REAL_TYPE RefVelocity;     //!< 代表速度
 
+    bool BatchedTransport; //!< ブロック内の粒子をまとめて計算する(PP_Transport::CalcBatch()を使う)かどうかのフラグ
+    bool AdaptiveTimeStep; //!< 粒子位置の流速から粒子毎にサブステップ数を決めるかどうかのフラグ (LPT_CalcArgs::divTが上限となる)
+    double CourantNumber;  //!< AdaptiveTimeStepが有効な時に、1サブステップで粒子が移動するセル数の上限
+    bool TemporalInterpolation; //!< 2時刻分の流速を受け取り、deltaTの間で時間方向にも線形補間するかどうかのフラグ
+    bool InterleavedBlockLayout; //!< キャッシュに登録する時にデータブロックをセル毎にxyz成分が並んだ形式に変換するかどうかのフラグ (既定値はfalse)
+                                 //!< 粒子毎の計算(BatchedTransport無効時)は速くなるが、BatchedTransportと併用すると最大15%程度遅くなる
+    bool PaddedBlockLayout;      //!< InterleavedBlockLayoutが有効な時に、1セルあたり4要素に詰め物をするかどうかのフラグ
+    bool WorkStealingScheduler;  //!< データブロック到着時の粒子計算をスレッド毎のキューとwork stealingで割り当てるかどうかのフラグ
+    int TransportChunkSize;      //!< WorkStealingSchedulerが有効な時に、1つの作業単位で計算する最大粒子数 (0以下の時はブロックを分割しない)
+    int NumaDomains;             //!< 1プロセスあたりのNUMAドメイン(ソケット)数 2以上の時はデータブロックと粒子をそれを計算するドメインのスレッドで確保し直す
+                                 //!< (WorkStealingSchedulerも有効になる)
+    int MortonSortThreshold;     //!< ブロック内の粒子数がこの値以上の時、計算前に粒子をセルのMorton順に並べ替える (0以下の時は並べ替えない)
+
     int CacheSize;         //!< データブロックのキャッシュに使う領域のサイズ(単位はMByte)
     int MaxRequestSize;    //!< 1プロセスあたりの最大同時データブロック要求数
 
     int NumInitialParticleProcs; //!< 粒子計算に使う初期プロセス数
+    int MaxParticlesPerProc;     //!< 稼働中の粒子計算プロセスあたりの平均粒子数がこの値を越えたら稼働プロセスを増やす (0以下の時は増やさない)
+    bool CostBasedStartPointDistribution; //!< 開始点を放出粒子数の予測値に基づいて分散するかどうかのフラグ
+    double StartPointCostHorizon;         //!< 寿命の指定が無い粒子の負荷を見積もる期間 (0以下の時は開始点の設定から決める)
+    std::string StartPointFileName;       //!< PPlib::PPlib::WriteStartPointsBinary()形式の開始点ファイル名 各プロセスが担当分だけを読み込み、APIで設定した開始点に追加する (空文字列の時は読み込まない。リスタート時はLPTlibStartPointsファイルに保存された開始点を使うので読み込まない)
+    bool BinaryStartPoints;               //!< APIで設定した開始点をLPTlibStartPoints.txtではなく無次元のバイナリ形式でLPTlibStartPoints.binに保存し、リスタート時は各プロセスが担当分だけを読み込むかどうかのフラグ (同じプロセス数でリスタートした時は初回実行時と同じ分散とIDになる)
 
     //! Constructor
     LPT_InitializeArgs() :
         d_bcv(NULL),
-        RefLength(1.0),
-        RefVelocity(1.0),
         ParticleComm(MPI_COMM_WORLD),
         FluidComm(MPI_COMM_WORLD),
         OutputFileName("ParticleData"),
@@ -74,23 +102,65 @@ struct LPT_InitializeArgs
         PMlibDetailedOutputFileName("PMlibDetailedOutput.txt"),
         CurrentTime(0.0),
         CurrentTimeStep(0),
-        MigrationInterval(-1),
         MigrateOnRestart(false),
+        MigrationInterval(-1),
+        MigrationThreshold(1.2),
+        BlockOwnership(false),
+        MortonBlockID(false),
+        OutputDimensional(true),
+        BinaryParticleOutput(false),
+        OutputChunkSize(65536),
+        AsynchronousParticleOutput(false),
+        CheckpointFileName("LPTlibCheckpoint"),
+        CheckpointRestart(false),
+        RefLength(1.0),
+        RefVelocity(1.0),
+        BatchedTransport(false),
+        AdaptiveTimeStep(false),
+        CourantNumber(0.5),
+        TemporalInterpolation(false),
+        InterleavedBlockLayout(false),
+        PaddedBlockLayout(false),
+        WorkStealingScheduler(false),
+        TransportChunkSize(1024),
+        NumaDomains(1),
+        MortonSortThreshold(-1),
         CacheSize(1024),
         MaxRequestSize(2700),
         NumInitialParticleProcs(-1),
-        OutputDimensional(true)
+        MaxParticlesPerProc(-1),
+        CostBasedStartPointDistribution(false),
+        StartPointCostHorizon(-1.0),
+        StartPointFileName(""),
+        BinaryStartPoints(false)
     {}
 };
 
 //! @brief LPT_CalcParticleDataの引数を保持する構造体
 struct LPT_CalcArgs
 {
-    double CurrentTime;       //!< 現在時刻
-    int CurrentTimeStep;      //!< 現在のタイムステップ
-    double deltaT;            //!< 時間積分幅 無次元
-    double divT;              //!< 粒子移動の積分に使う刻み幅の再分割数
-    REAL_TYPE* FluidVelocity; //!< 流速データのポインタ
+    double CurrentTime;          //!< 現在時刻
+    int CurrentTimeStep;         //!< 現在のタイムステップ
+    double deltaT;               //!< 時間積分幅 無次元
+    double divT;                 //!< 粒子移動の積分に使う刻み幅の再分割数
+    REAL_TYPE* FluidVelocity;    //!< 流速データのポインタ
+    REAL_TYPE* FluidVelocityOld; //!< CurrentTime-deltaTの時点の流速データのポインタ
+                                 //!< LPT_InitializeArgs::TemporalInterpolationが有効な時のみ使用し、NULLの時は時間補間を行なわない
+    PPlib::IntegratorType Integrator; //!< 粒子移動の積分に使う積分法
+    double IntegratorTolerance;       //!< 埋め込み型の積分法を使う時の1サブステップあたりの局所誤差の許容値(セル数単位)
+                                      //!< 正の値の時はdivTを上限として粒子毎にサブステップ数を決める
+
+    //! Constructor
+    LPT_CalcArgs() :
+        CurrentTime(0.0),
+        CurrentTimeStep(0),
+        deltaT(0.0),
+        divT(1),
+        FluidVelocity(NULL),
+        FluidVelocityOld(NULL),
+        Integrator(PPlib::INTEGRATOR_RKG),
+        IntegratorTolerance(-1.0)
+    {}
 };
 } // namespace LPT
 #endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef LPT_LPT_POSITION_TYPE_H
+#define LPT_LPT_POSITION_TYPE_H
+
+//! @brief 粒子座標の型
+//!
+//! configureの--with-positiontypeで指定した型を-DPOSITION_TYPEとして渡す
+//! 指定されていない場合(LPTlibのヘッダを使うユーザプログラムで-DPOSITION_TYPEを付けていない場合を含む)は
+//! 流体データと同じREAL_TYPEとする
+#ifndef POSITION_TYPE
+#define POSITION_TYPE REAL_TYPE
+#endif
+
+#endif
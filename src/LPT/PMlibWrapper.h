@@ -80,8 +80,15 @@ public:
         PM.setProperties("CalcParticle",               pm_lib::PerfMonitor::CALC);
         PM.setProperties("Discard_Cache",              pm_lib::PerfMonitor::CALC);
         PM.setProperties("ExchangeParticleContainers", pm_lib::PerfMonitor::CALC);
+        PM.setProperties("DetermineMigration",         pm_lib::PerfMonitor::COMM);
+        PM.setProperties("MigrateParticle",            pm_lib::PerfMonitor::COMM);
+        PM.setProperties("HandOffParticle",            pm_lib::PerfMonitor::COMM);
+        PM.setProperties("GrowActiveProcs",            pm_lib::PerfMonitor::COMM);
         PM.setProperties("Post",                       pm_lib::PerfMonitor::CALC);
         PM.setProperties("FileOutput",                 pm_lib::PerfMonitor::CALC);
+        PM.setProperties("FileOutputWait",             pm_lib::PerfMonitor::CALC);
+        PM.setProperties("Checkpoint",                 pm_lib::PerfMonitor::CALC);
+        PM.setProperties("ReadCheckpoint",             pm_lib::PerfMonitor::CALC);
 
         // CalcParticleセクション内の詳細区間
         PM.setProperties("CommDataF2P",                pm_lib::PerfMonitor::COMM, false);
@@ -0,0 +1,124 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef LPT_PARTICLE_CHECKPOINT_H
+#define LPT_PARTICLE_CHECKPOINT_H
+#include <cstddef>
+#include <string>
+#include "LPT_PositionType.h"
+
+//forward declaration
+namespace PPlib
+{
+class PPlib;
+class ParticleData;
+}
+
+namespace LPT
+{
+//! @brief チェックポイントファイルのヘッダ
+//!
+//! ファイルの先頭にこの構造体をそのまま書き出す
+struct CheckpointHeader
+{
+    char          Magic[8];           //!< "LPTCHKPT"
+    int           Version;            //!< ファイル形式のバージョン (現在は2)
+    int           SizeOfParticleData; //!< sizeof(PPlib::ParticleData)
+    int           SizeOfPosition;     //!< sizeof(POSITION_TYPE)
+    int           SizeOfReal;         //!< sizeof(REAL_TYPE)
+    int           Compact;            //!< PARTICLE_DATA_COMPACTが有効なビルドで出力した時は1
+    int           TimeStep;           //!< 出力したタイムステップ
+    int           Rank;               //!< 出力したプロセスのcomm_p内のRank番号
+    int           NumProcs;           //!< 出力時のcomm_p内のプロセス数
+    int           NumActiveProcs;     //!< 出力時の稼働中の粒子計算プロセス数
+    int           NumStartPoints;     //!< 保存した開始点の数
+    double        Time;               //!< 出力した時刻 (無次元)
+    unsigned long BlockIDSignature;   //!< 出力時のDecompositionManager::GetBlockIDSignature()の値
+    unsigned long NumParticles;       //!< 保存した粒子数
+    unsigned long ParticleOffset;     //!< 粒子データの先頭のファイル先頭からのオフセット(byte)
+    unsigned long StartPointOffset;   //!< 開始点データの先頭のファイル先頭からのオフセット(byte)
+    unsigned long StartPointBytes;    //!< 開始点データの大きさ(byte)
+};
+
+//! @brief リスタート用に粒子計算の状態をプロセス毎のバイナリファイルへ保存し、読み戻すクラス
+//!
+//! 可視化用の出力(LPT::LPT_OutputParticleData())とは独立に、有次元化や圧縮をせずに次のデータを保存する
+//! - 粒子データ: PPlib::ParticleDataをそのまま並べた配列 (BlockID、タイムステップを含む。コンテナの走査順なのでBlockID順に並ぶ)
+//! - 開始点: 自Rankが担当する開始点をPPlib::PPlib::PackStartPoints()のバイナリ形式で無次元のまま並べたもの (IDと放出済の粒子数、直近の放出時刻を含む)
+//! ファイル名は "BaseName_rank番号_タイムステップ.lptc" で、先頭にCheckpointHeader、64byte境界から粒子データ、その後に開始点データを置く
+//! 読み込み時はファイルをmmapして、粒子データの領域をそのままPPlib::ParticleDataの配列として参照する
+//! ParticleDataのレイアウト(REAL_TYPE, POSITION_TYPE, PARTICLE_DATA_COMPACT)が異なるビルドで出力したファイルは読み込めない
+class ParticleCheckpoint
+{
+    //non copyable
+    ParticleCheckpoint(const ParticleCheckpoint& obj);
+    ParticleCheckpoint& operator=(const ParticleCheckpoint& obj);
+
+public:
+    ParticleCheckpoint() : Data(NULL), DataSize(0), Mapped(false){}
+    ~ParticleCheckpoint()
+    {
+        Close();
+    }
+
+    //! チェックポイントファイルのファイル名を返す
+    static std::string GetFileName(const std::string& BaseName, const int& Rank, const int& TimeStep);
+
+    //! @brief PPlibが保持する粒子と開始点をチェックポイントファイルに書き出す
+    //!
+    //! 一時ファイルに書き出してから名前を変えるので、書き出しの途中で異常終了しても既存のファイルは壊れない
+    //! @param FileName       [in]  出力するファイル名
+    //! @param ptrPPlib       [in]  保存する粒子と開始点を保持するPPlib
+    //! @param TimeStep       [in]  タイムステップ
+    //! @param Time           [in]  時刻 (無次元)
+    //! @param ChunkSize      [in]  1度にファイルへ書き出す粒子数
+    //! @param WrittenBytes   [out] 書き出したデータ量(byte)
+    //! @retval 0 正常終了
+    static int Write(const std::string& FileName, PPlib::PPlib* ptrPPlib, const int& TimeStep, const double& Time, const int& ChunkSize, size_t* WrittenBytes);
+
+    //! @brief チェックポイントファイルを開いて、ヘッダを検査する
+    //!
+    //! ファイル全体をmmapし、mmapできなかった場合はメモリ上に一括で読み込む
+    //! @retval 0 正常終了
+    int Open(const std::string& FileName);
+
+    //! 開いているファイルを閉じる
+    void Close(void);
+
+    //! ヘッダを返す
+    const CheckpointHeader& GetHeader(void) const
+    {
+        return *reinterpret_cast<const CheckpointHeader*>(Data);
+    }
+
+    //! 粒子データの先頭を返す
+    const PPlib::ParticleData* GetParticles(void) const
+    {
+        return reinterpret_cast<const PPlib::ParticleData*>(Data+GetHeader().ParticleOffset);
+    }
+
+    //! 開始点データの先頭を返す (大きさはGetHeader().StartPointBytes)
+    const char* GetStartPointData(void) const
+    {
+        return Data+GetHeader().StartPointOffset;
+    }
+
+    //! ファイルの大きさ(byte)を返す
+    size_t GetFileSize(void) const
+    {
+        return DataSize;
+    }
+
+private:
+    char*  Data;     //!< ファイルの内容
+    size_t DataSize; //!< ファイルの大きさ
+    bool   Mapped;   //!< Dataがmmapした領域かどうかのフラグ (falseの時はnew[]で確保した領域)
+};
+} // namespace LPT
+#endif
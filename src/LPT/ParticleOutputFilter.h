@@ -0,0 +1,107 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef LPT_PARTICLE_OUTPUT_FILTER_H
+#define LPT_PARTICLE_OUTPUT_FILTER_H
+#include <set>
+#include <utility>
+
+namespace LPT
+{
+//! 粒子データの出力対象のフィールドを表すフラグ
+enum ParticleOutputField
+{
+    OUTPUT_COORDINATE = 1,
+    OUTPUT_VELOCITY   = 2,
+    OUTPUT_ID         = 4,
+    OUTPUT_START_TIME = 8,
+    OUTPUT_LIFE_TIME  = 16,
+    OUTPUT_ALL_FIELDS = 31
+};
+
+//! @brief 粒子データの出力対象を絞り込む条件
+//!
+//! LPT::LPT_OutputParticleData()の収集ループの中で判定するので、対象外の粒子はバッファにコピーされない
+//! 各条件は全て満たした粒子のみが出力される。デフォルトでは全タイムステップで全粒子の全フィールドを出力する
+struct ParticleOutputFilter
+{
+    int       TimeStepInterval; //!< このタイムステップ間隔でのみ出力する (1以下の時は毎回出力する)
+    int       SamplingStride;   //!< 粒子IDのハッシュ値がこの値で割り切れる粒子のみ出力する (1以下の時は全粒子)
+    int       Fields;           //!< 出力するフィールド (ParticleOutputFieldの論理和)
+    bool      UseBoundingBox;   //!< BoundingBoxで絞り込むかどうかのフラグ
+    REAL_TYPE BoundingBox[6];   //!< 出力する領域 (無次元の座標で xmin, ymin, zmin, xmax, ymax, zmax の順)
+    std::set<std::pair<int, int> > StartPoints; //!< 出力する粒子を放出した開始点のID (StartPointID1, StartPointID2) 空の時は全開始点
+
+    ParticleOutputFilter() : TimeStepInterval(1), SamplingStride(1), Fields(OUTPUT_ALL_FIELDS), UseBoundingBox(false)
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            BoundingBox[i] = 0.0;
+        }
+    }
+
+    //! 出力する領域を設定する
+    void SetBoundingBox(const REAL_TYPE Min[3], const REAL_TYPE Max[3])
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            BoundingBox[i]   = Min[i];
+            BoundingBox[i+3] = Max[i];
+        }
+        UseBoundingBox = true;
+    }
+
+    //! 出力対象の開始点を追加する
+    void AddStartPoint(const int& StartPointID1, const int& StartPointID2)
+    {
+        StartPoints.insert(std::make_pair(StartPointID1, StartPointID2));
+    }
+
+    //! 粒子単位の絞り込みを行なうかどうか
+    bool IsActive(void) const
+    {
+        return SamplingStride > 1 || UseBoundingBox || !StartPoints.empty();
+    }
+
+    //! 指定されたタイムステップが出力対象かどうか
+    bool IsOutputStep(const int& TimeStep) const
+    {
+        return TimeStepInterval <= 1 || TimeStep%TimeStepInterval == 0;
+    }
+
+    //! 粒子が出力対象かどうかを判定する
+    bool Select(const double& x, const double& y, const double& z, const int& StartPointID1, const int& StartPointID2, const int& ParticleID) const
+    {
+        if(SamplingStride > 1 && Hash(StartPointID1, StartPointID2, ParticleID)%SamplingStride != 0)return false;
+        if(UseBoundingBox)
+        {
+            if(x < BoundingBox[0] || y < BoundingBox[1] || z < BoundingBox[2])return false;
+            if(x > BoundingBox[3] || y > BoundingBox[4] || z > BoundingBox[5])return false;
+        }
+        if(!StartPoints.empty() && StartPoints.find(std::make_pair(StartPointID1, StartPointID2)) == StartPoints.end())return false;
+        return true;
+    }
+
+    //! @brief 粒子IDのハッシュ値を返す
+    //!
+    //! 粒子の出力順やプロセス数によらず同じ粒子が毎回選ばれるように、IDのみから計算する
+    static unsigned int Hash(const int& StartPointID1, const int& StartPointID2, const int& ParticleID)
+    {
+        unsigned int h = 2166136261u;
+        h = (h^static_cast<unsigned int>(StartPointID1))*16777619u;
+        h = (h^static_cast<unsigned int>(StartPointID2))*16777619u;
+        h = (h^static_cast<unsigned int>(ParticleID))*16777619u;
+        h ^= h>>15;
+        h *= 0x2c1b3c6du;
+        h ^= h>>12;
+        return h;
+    }
+};
+} // namespace LPT
+#endif
@@ -0,0 +1,234 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef LPT_PARTICLE_WRITER_H
+#define LPT_PARTICLE_WRITER_H
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <pthread.h>
+#include "ParticleOutputFilter.h"
+#include "LPT_PositionType.h"
+
+namespace LPT
+{
+//! @brief 粒子データの出力時に、一定数の粒子分のデータをまとめて受け渡すための構造体
+//!
+//! 有次元化と速度の基準値の減算は済ませた値が格納されている
+//! Begin()で指定されなかったフィールドの領域は参照しないこと
+struct ParticleChunk
+{
+    size_t         NumParticles; //!< このチャンクに含まれる粒子数
+    POSITION_TYPE* Coordinate;   //!< 粒子座標 (x, y, zの順に3*NumParticles要素)
+    REAL_TYPE*     Velocity;     //!< 粒子速度 (u, v, wの順に3*NumParticles要素)
+    int*           ID;           //!< StartPointID1, StartPointID2, ParticleIDの順に3*NumParticles要素
+    double*        StartTime;    //!< 粒子が放出された時刻
+    double*        LifeTime;     //!< 粒子の寿命
+};
+
+//! @brief 粒子データの出力先のインターフェース
+//!
+//! LPT::LPT_OutputParticleData()は粒子コンテナを1回だけ走査して、固定長のチャンク毎にWrite()を呼び出す
+//! 1回の出力でBegin(), Write()(0回以上), End()の順に呼ばれる
+//! Write()に渡したチャンクの領域は次のチャンクの収集に再利用されるので、必要ならWrite()の中でコピーすること
+class ParticleWriter
+{
+public:
+    virtual ~ParticleWriter(){}
+
+    //! @brief 出力を開始する
+    //! @param TimeStep     [in] 出力するタイムステップ
+    //! @param Time         [in] 出力する時刻
+    //! @param NumParticles [in] このプロセスが出力する粒子数の上限 (ParticleOutputFilterで除外される粒子を含む)
+    //! @param Fields       [in] 出力するフィールド (ParticleOutputFieldの論理和)
+    //! @retval 0 正常終了 (0以外の時はWrite(), End()は呼ばれない)
+    virtual int Begin(const int& TimeStep, const double& Time, const size_t& NumParticles, const int& Fields) = 0;
+
+    //! @brief Writer側で確保済の領域へ直接チャンクを収集させる場合に、その領域を返す
+    //!
+    //! trueを返した時は、ChunkのNumParticles以外のポインタが指す領域に粒子データを格納してからWrite()を呼ぶ
+    //! @param Offset       [in]  このチャンクの先頭の粒子が、Begin()以降で何番目の粒子か
+    //! @param NumParticles [in]  このチャンクの粒子数
+    //! @param Chunk        [out] 格納先の領域
+    //! @retval false LPT側で用意したバッファを使う
+    virtual bool GetChunkBuffer(const size_t& /*Offset*/, const size_t& /*NumParticles*/, ParticleChunk* /*Chunk*/)
+    {
+        return false;
+    }
+
+    //! @brief 1チャンク分の粒子データを出力する
+    //! @retval 0 正常終了 (0以外の時は残りのチャンクは出力せずにEnd()を呼ぶ)
+    virtual int Write(const ParticleChunk& Chunk) = 0;
+
+    //! @brief 出力を終了する
+    //!
+    //! 実際に出力した粒子数はWrite()に渡されたチャンクの粒子数の合計で、0の場合もある
+    //! @param vMinMax [in] 速度の大きさ, u, v, wの最大値と最小値 (最大値, 最小値の順)
+    virtual int End(const REAL_TYPE vMinMax[8]) = 0;
+
+    //! @brief Begin(), Write(), End()の中でMPIの通信を行なうかどうか
+    //!
+    //! trueの場合、MPIがMPI_THREAD_MULTIPLEで初期化されていなければバックグラウンドでの出力は行なわない
+    virtual bool UsesMPI(void) const
+    {
+        return true;
+    }
+};
+
+//! @brief PDMlibへ粒子データを出力するクラス
+//!
+//! PDMlib::Write()はコンテナ全体を1回で受け取るので、全粒子分の領域を確保してチャンクを集め
+//! End()でコンテナ毎に書き出す。書き出したコンテナの領域はその場で解放する
+//! このため出力時のメモリ使用量は出力する粒子数に比例し(float型で1粒子あたり約52byte)、OutputChunkSizeでは抑えられない
+//! チャンクはGetChunkBuffer()で確保済の領域へ直接収集させるので、途中のコピーは発生しない
+//! また、全粒子分が1回のWrite()で渡された場合は、その領域をコピーせずにEnd()で書き出す
+class PDMlibParticleWriter : public ParticleWriter
+{
+public:
+    PDMlibParticleWriter() : Coordinate(NULL), Velocity(NULL), ID(NULL), StartTime(NULL), LifeTime(NULL), Borrowed(false), Allocated(false), NumParticles(0), NumWritten(0), Fields(OUTPUT_ALL_FIELDS), TimeStep(0), Time(0.0){}
+    ~PDMlibParticleWriter()
+    {
+        Release();
+    }
+
+    int Begin(const int& arg_TimeStep, const double& arg_Time, const size_t& arg_NumParticles, const int& arg_Fields);
+    bool GetChunkBuffer(const size_t& Offset, const size_t& NumParticles, ParticleChunk* Chunk);
+    int Write(const ParticleChunk& Chunk);
+    int End(const REAL_TYPE vMinMax[8]);
+
+private:
+    //! 全粒子分の領域を確保する
+    bool Allocate(void);
+
+    //! 確保済の領域を全て解放する
+    void Release(void);
+
+    POSITION_TYPE* Coordinate;
+    REAL_TYPE*     Velocity;
+    int*           ID;
+    double*        StartTime;
+    double*        LifeTime;
+    bool           Borrowed;     //!< 各領域がWrite()で渡された領域をそのまま指しているかどうかのフラグ
+    bool           Allocated;    //!< 各領域を確保済かどうかのフラグ
+    size_t         NumParticles; //!< Begin()で指定された粒子数
+    size_t         NumWritten;   //!< Write()で受け取った粒子数
+    int            Fields;       //!< Begin()で指定された出力するフィールド
+    int            TimeStep;
+    double         Time;
+};
+
+//! @brief プロセス毎のバイナリファイルへ粒子データを逐次出力するクラス
+//!
+//! チャンクを受け取る度にそのまま書き出すので、出力に使うメモリはチャンクの大きさだけで粒子数に依存しない
+//! ファイル名は "BaseName_rank番号_タイムステップ.lpt" で、次の形式で出力する
+//! - ヘッダ: "LPTPDATA"(8byte), バージョン(int, 現在は2), sizeof(POSITION_TYPE)(int), sizeof(REAL_TYPE)(int),
+//!           タイムステップ(int), 出力したフィールド(int), 時刻(double), 粒子数(unsigned long)
+//! - チャンク毎に: 粒子数(unsigned long), 座標, 速度, ID, 放出時刻, 寿命 (ParticleChunkの各配列のうち出力対象のものをそのまま出力)
+//! - 末尾: 速度の最大値, 最小値 (REAL_TYPE 8要素)
+class BinaryParticleWriter : public ParticleWriter
+{
+public:
+    //! @param arg_BaseName [in] 出力ファイル名の先頭部分
+    //! @param arg_Rank     [in] ファイル名に付けるrank番号
+    BinaryParticleWriter(const std::string& arg_BaseName, const int& arg_Rank) : BaseName(arg_BaseName), Rank(arg_Rank), Fields(OUTPUT_ALL_FIELDS), NumWritten(0){}
+
+    int Begin(const int& TimeStep, const double& Time, const size_t& NumParticles, const int& arg_Fields);
+    int Write(const ParticleChunk& Chunk);
+    int End(const REAL_TYPE vMinMax[8]);
+    bool UsesMPI(void) const
+    {
+        return false;
+    }
+
+private:
+    std::string    BaseName;
+    int            Rank;
+    int            Fields;       //!< Begin()で指定された出力するフィールド
+    unsigned long  NumWritten;   //!< 出力済の粒子数
+    std::streampos CountPosition; //!< ヘッダの粒子数の位置 (End()で実際の粒子数に書き換える)
+    std::ofstream  File;
+};
+
+//! @brief 粒子データのスナップショットを取って、別スレッドで他のWriterへ出力するクラス
+//!
+//! 収集先のバッファを2面持ち、End()の時点で収集済のバッファをバックグラウンドスレッドに渡して
+//! 次の出力ではもう一方のバッファへ収集する。したがって呼び出し側は収集が終わった時点で次の計算に進める
+//! 前回の出力が終わっていない状態でEnd()が呼ばれた場合は、その終了を待ってから渡す
+//! バッファは2面とも全粒子分の大きさになるので、出力時のメモリ使用量は同期出力の約2倍になる
+class AsyncParticleWriter : public ParticleWriter
+{
+public:
+    AsyncParticleWriter();
+    ~AsyncParticleWriter();
+
+    //! @brief バックグラウンドスレッドを起動する
+    //! @retval false スレッドを起動できなかった (呼び出し側で同期出力に切り替えること)
+    bool Start(void);
+
+    //! @brief Targetをバックグラウンドスレッドから呼び出して良いかどうかを判定する
+    static bool CanRunInBackground(const ParticleWriter* Target);
+
+    //! @brief 次のBegin()からEnd()までの出力先を設定する
+    //!
+    //! 出力中のデータの出力先は変更しない
+    void SetTarget(ParticleWriter* arg_Target)
+    {
+        Target = arg_Target;
+    }
+
+    //! @brief 出力中のデータがあれば、その出力が終わるまで待つ
+    //! @retval 0 前回Wait()を呼んでから、バックグラウンドで行なった出力が全て正常に終了した
+    int Wait(void);
+
+    int Begin(const int& TimeStep, const double& Time, const size_t& NumParticles, const int& Fields);
+    bool GetChunkBuffer(const size_t& Offset, const size_t& NumParticles, ParticleChunk* Chunk);
+    int Write(const ParticleChunk& Chunk);
+    int End(const REAL_TYPE vMinMax[8]);
+
+private:
+    //! 1回の出力分の粒子データ
+    struct Snapshot
+    {
+        std::vector<POSITION_TYPE> Coordinate;
+        std::vector<REAL_TYPE>     Velocity;
+        std::vector<int>           ID;
+        std::vector<double>        StartTime;
+        std::vector<double>        LifeTime;
+        size_t                     NumParticles;
+        int                        Fields;
+        int                        TimeStep;
+        double                     Time;
+        REAL_TYPE                  vMinMax[8];
+        ParticleWriter*            Target;
+    };
+
+    //! pthread_create()に渡すエントリポイント
+    static void* ThreadMain(void* arg);
+
+    //! バックグラウンドスレッドの処理本体
+    void Run(void);
+
+    //! スナップショットを出力先へ書き出す
+    int Flush(Snapshot* Data);
+
+    Snapshot        Buffers[2];
+    Snapshot*       Filling;   //!< 収集中のバッファ
+    Snapshot*       Pending;   //!< 出力待ちまたは出力中のバッファ (無い時はNULL)
+    ParticleWriter* Target;    //!< 次の出力の出力先
+    size_t          NumWritten; //!< 収集中のバッファにWrite()で格納済の粒子数
+    pthread_t       Thread;
+    pthread_mutex_t Mutex;
+    pthread_cond_t  Cond;
+    bool            Running;   //!< バックグラウンドスレッドが起動しているかどうかのフラグ
+    bool            Quit;      //!< バックグラウンドスレッドの終了要求
+    int             LastError; //!< バックグラウンドでの出力で発生したエラーの有無
+};
+} // namespace LPT
+#endif
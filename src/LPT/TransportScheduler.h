@@ -0,0 +1,427 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef LPT_TRANSPORT_SCHEDULER_H
+#define LPT_TRANSPORT_SCHEDULER_H
+#include <list>
+#include <map>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <sched.h>
+#include <omp.h>
+#include "LPT_LogOutput.h"
+
+namespace PPlib
+{
+//forward declaration
+class ParticleData;
+}
+namespace DSlib
+{
+//forward declaration
+struct DataBlock;
+}
+
+namespace LPT
+{
+//! @brief 粒子計算の作業単位
+struct TransportWork
+{
+    long BlockID;                               //!< 計算に使うデータブロックのID
+    std::list<PPlib::ParticleData*>* Particles; //!< 計算する粒子のlist (NULLの時はBlockIDで再開する中断中の粒子を計算する)
+    double Cost;                                //!< 計算コストの見積もり値 (粒子数*サブステップ数)
+    DSlib::DataBlock* Block;                    //!< キャッシュ登録前のデータブロック (NULLで無い時は、登録と粒子の配置替えをしてから作業単位に分割する)
+    int Domain;                                 //!< 計算するNUMAドメイン (負の時はどのスレッドが計算しても良い)
+
+    bool operator>(const TransportWork& obj) const
+    {
+        return Cost > obj.Cost;
+    }
+};
+
+//! @brief データブロック到着時の粒子計算を、スレッド毎のキューと他スレッドのキューからの奪取(work stealing)で割り当てるスケジューラ
+//!
+//! 到着したデータブロックの粒子はChunkSize個毎の作業単位に分割し、各スレッドのキューにラウンドロビンで登録する
+//! 各キューはコストの見積もり値の降順に並べ、自スレッドは先頭(大きい方)から、他スレッドは末尾(小さい方)から取り出す
+//! コストはブロック毎に前回計算した時の1粒子あたりのサブステップ数から見積もるので、タイムステップをまたいで保持する
+//!
+//! NUMAドメイン数が2以上の時は、スレッドをスレッド番号順にドメイン数で等分し(OMP_PROC_BIND=close等で連続する番号のスレッドが
+//! 同じソケットに配置されていることを前提とする)、到着したブロックを見積もりコストの合計が最も小さいドメインに割り当てる
+//! ブロックはまず1つの準備用の作業単位としてそのドメインのキューに登録し、準備用の作業単位は他ドメインのスレッドには渡さない
+//! 準備を終えたブロックの作業単位もそのドメインのキューに登録し、奪う時は同じドメインのキューを優先する
+class TransportScheduler
+{
+    //non copyable
+    TransportScheduler(const TransportScheduler& obj);
+    TransportScheduler& operator=(const TransportScheduler& obj);
+
+public:
+    TransportScheduler() : ChunkSize(1024), NumDomains(1), NumActiveDomains(1), NumQueues(0), NextQueue(0), NumPending(0), Closed(true), DefaultSubSteps(1.0)
+    {
+        omp_init_lock(&CostLock);
+        omp_init_lock(&NextQueueLock);
+    }
+
+    ~TransportScheduler()
+    {
+        for(std::vector<omp_lock_t>::iterator it = QueueLocks.begin(); it != QueueLocks.end(); ++it)
+        {
+            omp_destroy_lock(&(*it));
+        }
+        omp_destroy_lock(&CostLock);
+        omp_destroy_lock(&NextQueueLock);
+    }
+
+    //! 作業単位あたりの最大粒子数を設定する (0以下の時はブロックを分割しない)
+    void SetChunkSize(const int& ChunkSize)
+    {
+        this->ChunkSize = ChunkSize;
+    }
+
+    //! NUMAドメイン数を設定する (1以下の時はドメインを区別しない)
+    void SetNumDomains(const int& NumDomains)
+    {
+        this->NumDomains = std::max(NumDomains, 1);
+    }
+
+    //! タイムステップの開始時に呼び出し、統計情報を初期化する
+    //
+    //! @param NumThreads      [in] 粒子計算に使うスレッド数
+    //! @param DefaultSubSteps [in] 計算実績の無いブロックの1粒子あたりのサブステップ数の見積もり値
+    void BeginStep(const int& NumThreads, const double& DefaultSubSteps)
+    {
+        if(NumQueues != NumThreads)
+        {
+            for(std::vector<omp_lock_t>::iterator it = QueueLocks.begin(); it != QueueLocks.end(); ++it)
+            {
+                omp_destroy_lock(&(*it));
+            }
+            NumQueues = NumThreads;
+            Queues.assign(NumQueues, std::deque<TransportWork>());
+            QueueLocks.resize(NumQueues);
+            for(std::vector<omp_lock_t>::iterator it = QueueLocks.begin(); it != QueueLocks.end(); ++it)
+            {
+                omp_init_lock(&(*it));
+            }
+        }
+        //スレッド数がドメイン数より少ない時は、スレッド数をドメイン数とみなす
+        NumActiveDomains = std::min(NumDomains, NumQueues);
+        DomainBegin.resize(NumActiveDomains+1);
+        for(int d = 0; d <= NumActiveDomains; d++)
+        {
+            DomainBegin[d] = (d*NumQueues+NumActiveDomains-1)/NumActiveDomains;
+        }
+        DomainCost.assign(NumActiveDomains, 0.0);
+        NextQueueInDomain.assign(NumActiveDomains, 0);
+
+        this->DefaultSubSteps = DefaultSubSteps;
+        BusyTime.assign(NumQueues, 0.0);
+        IdleTime.assign(NumQueues, 0.0);
+        NumWorks.assign(NumQueues, 0);
+        NumStolen.assign(NumQueues, 0);
+        NumRemoteStolen.assign(NumQueues, 0);
+    }
+
+    //! 作業単位の登録を開始する (並列領域の外で呼び出すこと)
+    void Open(void)
+    {
+        NumPending = 0;
+        Closed     = false;
+    }
+
+    //! 作業単位の登録が終わったことを通知する
+    void Close(void)
+    {
+        #pragma omp flush
+        Closed = true;
+        #pragma omp flush
+    }
+
+    //! 到着したデータブロックの粒子を作業単位に分割して登録する
+    //
+    //! そのブロックで再開する中断中の粒子の計算も1つの作業単位として併せて登録する
+    //! Particlesはスケジューラが分割して作業単位に渡すので、呼び出し側で参照、deleteしてはならない
+    //! 登録は1スレッドからのみ行なうこと
+    void Push(const long& BlockID, std::list<PPlib::ParticleData*>* Particles)
+    {
+        if(BlockID < 0)return;
+        Split(BlockID, Particles, -1);
+    }
+
+    //! キャッシュ登録前のデータブロックとその粒子を、1つの準備用の作業単位としてNUMAドメインに割り当てて登録する
+    //
+    //! 準備用の作業単位を取り出したスレッドは、データブロックと粒子を自スレッドで確保した領域に移した後に
+    //! PushPrepared()で作業単位に分割して登録すること
+    //! 登録は1スレッドからのみ行なうこと
+    //! @param Block        [in] DSlib::ReceiveDataBlock()で生成したデータブロック
+    //! @param Particles    [in] そのブロックに含まれる粒子のlist
+    //! @param NumParticles [in] Particlesに含まれる粒子数
+    void PushBlock(DSlib::DataBlock* Block, const long& BlockID, std::list<PPlib::ParticleData*>* Particles, const size_t& NumParticles)
+    {
+        TransportWork Work;
+        Work.BlockID   = BlockID;
+        Work.Particles = Particles;
+        Work.Block     = Block;
+        Work.Cost      = NumParticles*EstimateSubSteps(BlockID);
+
+        //見積もりコストの合計が最も小さいドメインに割り当てる
+        Work.Domain = 0;
+        #pragma omp flush
+        for(int d = 1; d < NumActiveDomains; d++)
+        {
+            if(DomainCost[d] < DomainCost[Work.Domain])Work.Domain = d;
+        }
+        #pragma omp atomic
+        DomainCost[Work.Domain] += Work.Cost;
+        Enqueue(Work);
+    }
+
+    //! 準備を終えたブロックの粒子を、準備用の作業単位と同じドメインに作業単位に分割して登録する
+    void PushPrepared(const TransportWork& Prepared)
+    {
+        Split(Prepared.BlockID, Prepared.Particles, Prepared.Domain);
+    }
+
+    //! 計算する作業単位を取り出す
+    //
+    //! 自スレッドのキューが空の時は、他スレッドのキューの末尾から奪う
+    //! 全てのキューが空の時は、Waitがtrueなら登録を待ち、falseなら直ちにfalseを返す
+    //! Close()済で全てのキューが空になったらfalseを返す
+    bool Pop(const int& ThreadID, TransportWork* Work, const bool& Wait)
+    {
+        double IdleStartTime = -1.0;
+        for(;;)
+        {
+            if(TryPop(ThreadID, Work))
+            {
+                if(IdleStartTime >= 0.0)IdleTime[ThreadID] += omp_get_wtime()-IdleStartTime;
+                ++NumWorks[ThreadID];
+                return true;
+            }
+            #pragma omp flush
+            if(!Wait || (Closed && NumPending <= 0))
+            {
+                if(IdleStartTime >= 0.0)IdleTime[ThreadID] += omp_get_wtime()-IdleStartTime;
+                return false;
+            }
+            if(IdleStartTime < 0.0)IdleStartTime = omp_get_wtime();
+            sched_yield();
+        }
+    }
+
+    //! 作業単位の計算時間を記録し、そのブロックの1粒子あたりのサブステップ数の見積もりを更新する
+    //
+    //! 取り出した全ての作業単位について、計算後に呼び出すこと
+    void Finished(const int& ThreadID, const TransportWork& Work, const double& Time, const long& NumAdvanced, const long& NumSubSteps)
+    {
+        BusyTime[ThreadID] += Time;
+        //準備用の作業単位のコストはPushBlock()で加算しているので、ここで差し引く
+        if(Work.Domain >= 0)
+        {
+            #pragma omp atomic
+            DomainCost[Work.Domain] -= Work.Cost;
+        }
+        #pragma omp atomic
+        --NumPending;
+        if(Work.Particles == NULL || Work.Block != NULL || NumAdvanced <= 0)return;
+        omp_set_lock(&CostLock);
+        SubStepsPerParticle[Work.BlockID] = static_cast<double>(NumSubSteps)/NumAdvanced;
+        omp_unset_lock(&CostLock);
+    }
+
+    //! スレッド毎の計算時間と待ち時間の統計をログに出力する
+    void Report(void)
+    {
+        if(NumQueues <= 0)return;
+        double MaxBusy  = 0.0;
+        double SumBusy  = 0.0;
+        double SumIdle  = 0.0;
+        long   SumWorks = 0;
+        long   SumStolen = 0;
+        long   SumRemoteStolen = 0;
+        for(int i = 0; i < NumQueues; i++)
+        {
+            MaxBusy    = std::max(MaxBusy, BusyTime[i]);
+            SumBusy   += BusyTime[i];
+            SumIdle   += IdleTime[i];
+            SumWorks  += NumWorks[i];
+            SumStolen += NumStolen[i];
+            SumRemoteStolen += NumRemoteStolen[i];
+        }
+        LPT_LOG::GetInstance()->INFO("Scheduler: number of works = ", SumWorks);
+        LPT_LOG::GetInstance()->INFO("Scheduler: number of stolen works = ", SumStolen);
+        if(NumActiveDomains > 1)
+        {
+            LPT_LOG::GetInstance()->INFO("Scheduler: number of works stolen from other NUMA domains = ", SumRemoteStolen);
+        }
+        LPT_LOG::GetInstance()->INFO("Scheduler: busy time per thread (max) [s] = ", MaxBusy);
+        LPT_LOG::GetInstance()->INFO("Scheduler: busy time per thread (avg) [s] = ", SumBusy/NumQueues);
+        LPT_LOG::GetInstance()->INFO("Scheduler: idle time per thread (avg) [s] = ", SumIdle/NumQueues);
+        if(SumBusy > 0.0)
+        {
+            LPT_LOG::GetInstance()->INFO("Scheduler: busy time imbalance (max/avg) = ", MaxBusy*NumQueues/SumBusy);
+        }
+    }
+
+private:
+    //! 1粒子あたりのサブステップ数の見積もり値を返す
+    double EstimateSubSteps(const long& BlockID)
+    {
+        double rt = DefaultSubSteps;
+        omp_set_lock(&CostLock);
+        std::map<long, double>::iterator it = SubStepsPerParticle.find(BlockID);
+        if(it != SubStepsPerParticle.end())
+        {
+            rt = it->second;
+        }
+        omp_unset_lock(&CostLock);
+        return rt;
+    }
+
+    //! 粒子をChunkSize個毎の作業単位に分割し、再開する中断中の粒子の作業単位と併せて登録する
+    void Split(const long& BlockID, std::list<PPlib::ParticleData*>* Particles, const int& Domain)
+    {
+        const double  SubSteps = EstimateSubSteps(BlockID);
+        TransportWork Work;
+        Work.BlockID = BlockID;
+        Work.Block   = NULL;
+        Work.Domain  = Domain;
+        while(Particles != NULL && !Particles->empty())
+        {
+            //std::list::size()はO(N)なので分割しながら数える
+            std::list<PPlib::ParticleData*>::iterator it_end = Particles->begin();
+            long NumParticles                                = 0;
+            while(it_end != Particles->end() && (ChunkSize <= 0 || NumParticles < ChunkSize))
+            {
+                ++it_end;
+                ++NumParticles;
+            }
+            if(it_end == Particles->end())
+            {
+                Work.Particles = Particles;
+                Particles      = NULL;
+            }else{
+                Work.Particles = new std::list<PPlib::ParticleData*>;
+                Work.Particles->splice(Work.Particles->end(), *Particles, Particles->begin(), it_end);
+            }
+            Work.Cost = NumParticles*SubSteps;
+            if(Domain >= 0)
+            {
+                #pragma omp atomic
+                DomainCost[Domain] += Work.Cost;
+            }
+            Enqueue(Work);
+        }
+        delete Particles;
+
+        Work.Particles = NULL;
+        Work.Cost      = 0.0;
+        Enqueue(Work);
+    }
+
+    //! 作業単位を次のキューにコストの降順を保って追加する
+    //
+    //! ドメインが指定されている時は、そのドメインのスレッドのキューに順に追加する
+    void Enqueue(const TransportWork& Work)
+    {
+        omp_set_lock(&NextQueueLock);
+        int Queue;
+        if(Work.Domain < 0)
+        {
+            Queue     = NextQueue;
+            NextQueue = (NextQueue+1)%NumQueues;
+        }else{
+            const int NumDomainQueues = DomainBegin[Work.Domain+1]-DomainBegin[Work.Domain];
+            Queue                            = DomainBegin[Work.Domain]+NextQueueInDomain[Work.Domain];
+            NextQueueInDomain[Work.Domain] = (NextQueueInDomain[Work.Domain]+1)%NumDomainQueues;
+        }
+        omp_unset_lock(&NextQueueLock);
+
+        #pragma omp atomic
+        ++NumPending;
+        omp_set_lock(&QueueLocks[Queue]);
+        Queues[Queue].insert(std::upper_bound(Queues[Queue].begin(), Queues[Queue].end(), Work, std::greater<TransportWork>()), Work);
+        omp_unset_lock(&QueueLocks[Queue]);
+    }
+
+    //! スレッドが所属するNUMAドメインを返す
+    int GetDomain(const int& ThreadID) const
+    {
+        return ThreadID*NumActiveDomains/NumQueues;
+    }
+
+    //! 自スレッドのキューの先頭、または他スレッドのキューの末尾から作業単位を1つ取り出す
+    //
+    //! 他スレッドのキューは同じドメインのものを優先し、他ドメインのキューからは準備用の作業単位を取り出さない
+    bool TryPop(const int& ThreadID, TransportWork* Work)
+    {
+        omp_set_lock(&QueueLocks[ThreadID]);
+        if(!Queues[ThreadID].empty())
+        {
+            *Work = Queues[ThreadID].front();
+            Queues[ThreadID].pop_front();
+            omp_unset_lock(&QueueLocks[ThreadID]);
+            return true;
+        }
+        omp_unset_lock(&QueueLocks[ThreadID]);
+
+        const int MyDomain = GetDomain(ThreadID);
+        for(int pass = 0; pass < 2; pass++)
+        {
+            for(int i = 1; i < NumQueues; i++)
+            {
+                const int  Queue  = (ThreadID+i)%NumQueues;
+                const bool Remote = GetDomain(Queue) != MyDomain;
+                if(Remote != (pass == 1))continue;
+                omp_set_lock(&QueueLocks[Queue]);
+                if(!Queues[Queue].empty() && !(Remote && Queues[Queue].back().Block != NULL))
+                {
+                    *Work = Queues[Queue].back();
+                    Queues[Queue].pop_back();
+                    omp_unset_lock(&QueueLocks[Queue]);
+                    ++NumStolen[ThreadID];
+                    if(Remote)++NumRemoteStolen[ThreadID];
+                    return true;
+                }
+                omp_unset_lock(&QueueLocks[Queue]);
+            }
+        }
+        return false;
+    }
+
+    int  ChunkSize;           //!< 作業単位あたりの最大粒子数
+    int  NumDomains;          //!< NUMAドメイン数
+    int  NumActiveDomains;    //!< 作業単位を割り当てるNUMAドメイン数 (=min(NumDomains, NumQueues))
+    int  NumQueues;           //!< キューの数 (=スレッド数)
+    int  NextQueue;           //!< 次に作業単位を登録するキュー
+    long NumPending;          //!< 登録されてから計算が終わっていない作業単位の総数
+    bool Closed;              //!< 作業単位の登録が終わったかどうかのフラグ
+    double DefaultSubSteps;   //!< 計算実績の無いブロックの1粒子あたりのサブステップ数の見積もり値
+
+    std::vector<std::deque<TransportWork> > Queues;     //!< スレッド毎の作業単位のキュー
+    std::vector<omp_lock_t>                 QueueLocks; //!< キュー毎のロック変数
+    omp_lock_t                              NextQueueLock; //!< NextQueue, NextQueueInDomainの操作に関わるロック変数
+
+    std::vector<int>    DomainBegin;       //!< ドメイン毎の先頭のスレッド番号 (末尾はスレッド数)
+    std::vector<double> DomainCost;        //!< ドメイン毎の計算が終わっていない作業単位の見積もりコストの合計
+    std::vector<int>    NextQueueInDomain; //!< ドメイン毎に次に作業単位を登録するキュー(ドメイン内の番号)
+
+    std::map<long, double> SubStepsPerParticle; //!< ブロック毎の1粒子あたりのサブステップ数の実績値
+    omp_lock_t             CostLock;            //!< SubStepsPerParticleの操作に関わるロック変数
+
+    std::vector<double> BusyTime;  //!< スレッド毎の作業単位の計算時間
+    std::vector<double> IdleTime;  //!< スレッド毎の作業単位の待ち時間
+    std::vector<long>   NumWorks;  //!< スレッド毎に計算した作業単位の数
+    std::vector<long>   NumStolen; //!< スレッド毎に他スレッドのキューから奪った作業単位の数
+    std::vector<long>   NumRemoteStolen; //!< スレッド毎に他ドメインのスレッドのキューから奪った作業単位の数
+};
+} // namespace LPT
+#endif
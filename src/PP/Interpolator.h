@@ -9,6 +9,7 @@
 
 #ifndef PPLIB__INTERPOLATOR_H
 #define PPLIB__INTERPOLATOR_H
+#include "LPT_PositionType.h"
 
 //forward declaration
 namespace DSlib
@@ -25,19 +26,65 @@ public:
     //! @param x_I  [in]  粒子座標
     //! @param didx [in]  補間対象データのindex番号
     //! @param dval [out] 補間したベクトルデータを格納する領域
-    static bool InterpolateData(const DSlib::DataBlock&DataBlock, const REAL_TYPE x_I[3], REAL_TYPE dval[3]);
+    //! 座標はPOSITION_TYPE、流速データと補間の重みはREAL_TYPEで扱う
+    static bool InterpolateData(const DSlib::DataBlock&DataBlock, const POSITION_TYPE x_I[3], REAL_TYPE dval[3]);
+
+    //! @brief NumParticles個の粒子位置でのベクトルデータの補間をまとめて行なう
+    //!
+    //! 座標、補間結果ともにSoA形式で渡す。1粒子版と同じ演算順序で計算する
+    //! @param NumParticles [in]  粒子数
+    //! @param x_I          [in]  粒子のx座標(データブロック内のローカル座標)
+    //! @param y_I          [in]  粒子のy座標(データブロック内のローカル座標)
+    //! @param z_I          [in]  粒子のz座標(データブロック内のローカル座標)
+    //! @param u            [out] 補間したベクトルデータのx成分
+    //! @param v            [out] 補間したベクトルデータのy成分
+    //! @param w            [out] 補間したベクトルデータのz成分
+    static bool InterpolateData(const DSlib::DataBlock&DataBlock, const int& NumParticles, const POSITION_TYPE* x_I, const POSITION_TYPE* y_I, const POSITION_TYPE* z_I, REAL_TYPE* u, REAL_TYPE* v, REAL_TYPE* w);
+
+    //! @brief 2時刻分の流速を保持するデータブロックで、時間方向にも線形補間したベクトルデータを求める
+    //!
+    //! DataBlock.DataPrevがNULLの時、およびTheta>=1の時はDataのみを使って補間する
+    //! @param x_I   [in]  粒子座標
+    //! @param Theta [in]  補間する時刻 (DataPrevの時刻を0, Dataの時刻を1とした相対値)
+    //! @param dval  [out] 補間したベクトルデータを格納する領域
+    static bool InterpolateData(const DSlib::DataBlock&DataBlock, const POSITION_TYPE x_I[3], const double& Theta, REAL_TYPE dval[3]);
+
+    //! @brief NumParticles個の粒子位置で、時間方向にも線形補間したベクトルデータをまとめて求める
+    //! @param Theta [in] 補間する時刻 (DataPrevの時刻を0, Dataの時刻を1とした相対値)
+    //! その他の引数はSoA版のInterpolateData()と同じ
+    static bool InterpolateData(const DSlib::DataBlock&DataBlock, const int& NumParticles, const POSITION_TYPE* x_I, const POSITION_TYPE* y_I, const POSITION_TYPE* z_I, const double& Theta, REAL_TYPE* u, REAL_TYPE* v, REAL_TYPE* w);
+
+    //! @brief 時間積分の被積分関数として、補間したベクトルデータをセル幅で割った値(セル数/時間)を求める
+    //!
+    //! インターリーブ形式のデータブロックでは補間とセル幅での除算を1つのループで行なう (結果は成分毎に並んだ形式と同じ)
+    //! 引数の意味は時間補間版のInterpolateData()と同じ
+    static bool InterpolateIntegrand(const DSlib::DataBlock&DataBlock, const POSITION_TYPE x_I[3], const double& Theta, REAL_TYPE func[3]);
+
+    //! @brief InterpolateIntegrand()のSoA版
+    static bool InterpolateIntegrand(const DSlib::DataBlock&DataBlock, const int& NumParticles, const POSITION_TYPE* x_I, const POSITION_TYPE* y_I, const POSITION_TYPE* z_I, const double& Theta, REAL_TYPE* u, REAL_TYPE* v, REAL_TYPE* w);
 
     //! @brief 解析領域全体でのグローバル座標の座標値を、データブロック内のローカル座標に変換する
     //! @param [in]  x   解析領域内でのグローバル座標
     //! @param [out] x_i データブロック内でのローカル座標
     //! グローバル座標では、袖領域を含まない範囲で一番端のセルのコーナーを原点とする
     //! ローカル座標では、袖領域を含む範囲で一番端のセルの中心を原点とする
-    static void ConvXtoI(const REAL_TYPE x_g[3], REAL_TYPE x_l[3], const REAL_TYPE orig[3], const REAL_TYPE pitch[3]);
+    static void ConvXtoI(const POSITION_TYPE x_g[3], POSITION_TYPE x_l[3], const POSITION_TYPE orig[3], const REAL_TYPE pitch[3]);
 
     //! @brief ConvXtoIの逆変換を行う
     //! @param x_I [in]  データブロック内でのローカル座標
     //! @param x   [out] 解析領域内でのグローバル座標
-    static void ConvItoX(const REAL_TYPE x_l[3], REAL_TYPE x_g[3], const REAL_TYPE orig[3], const REAL_TYPE pitch[3]);
+    static void ConvItoX(const POSITION_TYPE x_l[3], POSITION_TYPE x_g[3], const POSITION_TYPE orig[3], const REAL_TYPE pitch[3]);
+
+private:
+    //! @brief インターリーブ形式(DataBlock.CellStride>0)のデータブロック用の補間
+    //!
+    //! セルの8隅のxyz成分を連続した領域から読み、オフセットは事前に計算したDataBlock.Strideから求める
+    //! @param Theta [in]  補間する時刻 (1以上またはDataPrevがNULLの時はDataのみを使う)
+    //! @param Divisor [in]  補間結果の成分毎に割る値
+    static void InterpolateInterleaved(const DSlib::DataBlock&DataBlock, const POSITION_TYPE x_I[3], const double& Theta, const REAL_TYPE Divisor[3], REAL_TYPE dval[3]);
+
+    //! @brief InterpolateInterleaved()のSoA版
+    static void InterpolateInterleaved(const DSlib::DataBlock&DataBlock, const int& NumParticles, const POSITION_TYPE* x_I, const POSITION_TYPE* y_I, const POSITION_TYPE* z_I, const double& Theta, const REAL_TYPE Divisor[3], REAL_TYPE* u, REAL_TYPE* v, REAL_TYPE* w);
 };
 } // namespace PPlib
 #endif
\ No newline at end of file
@@ -12,6 +12,8 @@
 
 #include <iostream>
 #include <cmath>
+#include "LPT_PositionType.h"
+#include "PP_IntegratorType.h"
 
 //forward declaration
 namespace DSlib
@@ -21,21 +23,80 @@ class DataBlock;
 
 namespace PPlib
 {
-//! @brief 4次のルンゲ=クッタ法による速度場の積分を行なう。
+//! @brief 速度場の積分を行なう。
 class PP_Integrator
 {
     //! @brief ルンゲ=クッタ用の係数を計算する。
     //! @param DataBlock   [in]   計算対象の粒子が存在するデータブロック
     //! @param x_i         [in]   粒子座標
+    //! @param Theta       [in]   流速を評価する時刻 (DataBlock.DataPrevの時刻を0, DataBlock.Dataの時刻を1とした相対値)
     //! @param func        [out]  ルンゲ=クッタ積分用の係数を計算した結果を格納する
-    static bool GetIntegrand(const DSlib::DataBlock&DataBlock, const REAL_TYPE x_i[3], REAL_TYPE func[3]);
+    static bool GetIntegrand(const DSlib::DataBlock&DataBlock, const POSITION_TYPE x_i[3], const double& Theta, REAL_TYPE func[3]);
+
+    //! @brief ブッチャー表で与えた陽的ルンゲ=クッタ法による速度場の積分を行なう
+    //! @param Error [out] 埋め込み型の時は局所誤差の推定値(セル数単位)、それ以外の時は0を格納する (NULLの時は格納しない)
+    //! 他の引数はRKG()と同じ
+    //! Schemeは段数NumStages, 埋め込み型かどうかのEmbedded, 係数c, a, b, e(=5次と4次の重みの差)を持つこと
+    template<class Scheme>
+    static int ExplicitRK(const DSlib::DataBlock&DataBlock, const double t_step, POSITION_TYPE x_i[3], const double& Theta0, const double& dTheta, double* Error);
+
+    //! @brief ExplicitRK()のSoA版
+    //! @param Error [out] 粒子毎の局所誤差の推定値 (NULLの時は格納しない)
+    template<class Scheme>
+    static int ExplicitRK(const DSlib::DataBlock&DataBlock, const double t_step, const int& NumParticles, POSITION_TYPE* x_i, POSITION_TYPE* y_i, POSITION_TYPE* z_i, const double& Theta0, const double& dTheta, double* Error);
 
 public:
+    //! 複数粒子をまとめて積分する時の1回あたりの最大粒子数
+    static const int BatchSize = 64;
+
     //! @brief 4次ルンゲ=クッタ法による速度場の積分を行なう
     //! @param DataBlock  [in]   計算対象の粒子が存在するデータブロック
     //! @param t_step  [in]    ルンゲ=クッタ積分の時間刻み
     //! @param x_i     [inout] 粒子座標
-    static int RKG(const DSlib::DataBlock&DataBlock, const double t_step, REAL_TYPE x_i[3]);
+    //! @param Theta0  [in]    このステップの開始時刻 (DataBlock.DataPrevの時刻を0, DataBlock.Dataの時刻を1とした相対値)
+    //! @param dTheta  [in]    t_stepを同じ相対値で表した幅
+    //! DataBlock.DataPrevがNULLの時はTheta0, dThetaに関わらずDataBlock.Dataの流速で積分する
+    static int RKG(const DSlib::DataBlock&DataBlock, const double t_step, POSITION_TYPE x_i[3], const double& Theta0 = 1.0, const double& dTheta = 0.0);
+
+    //! @brief 同じデータブロック内のNumParticles個の粒子をまとめて4次ルンゲ=クッタ法で積分する
+    //!
+    //! 座標はSoA形式で渡し、1粒子版のRKG()と同じ演算順序で計算する
+    //! @param DataBlock    [in]    計算対象の粒子が存在するデータブロック
+    //! @param t_step       [in]    ルンゲ=クッタ積分の時間刻み
+    //! @param NumParticles [in]    粒子数(BatchSize以下)
+    //! @param x_i          [inout] 粒子のx座標(データブロック内のローカル座標)
+    //! @param y_i          [inout] 粒子のy座標(データブロック内のローカル座標)
+    //! @param z_i          [inout] 粒子のz座標(データブロック内のローカル座標)
+    //! @param Theta0       [in]    このステップの開始時刻 (1粒子版のRKG()と同じ)
+    //! @param dTheta       [in]    t_stepを相対値で表した幅 (1粒子版のRKG()と同じ)
+    static int RKG(const DSlib::DataBlock&DataBlock, const double t_step, const int& NumParticles, POSITION_TYPE* x_i, POSITION_TYPE* y_i, POSITION_TYPE* z_i, const double& Theta0 = 1.0, const double& dTheta = 0.0);
+
+    //! @brief Typeで指定した積分法で速度場の積分を行なう
+    //! @param Type   [in]  積分法
+    //! @param Error  [out] 局所誤差の推定値(セル数単位) 埋め込み型以外の積分法では0を格納する (NULLの時は格納しない)
+    //! 他の引数はRKG()と同じ
+    static int Integrate(const IntegratorType& Type, const DSlib::DataBlock&DataBlock, const double t_step, POSITION_TYPE x_i[3], const double& Theta0 = 1.0, const double& dTheta = 0.0, double* Error = NULL);
+
+    //! @brief Typeで指定した積分法で同じデータブロック内のNumParticles個の粒子をまとめて積分する
+    //! @param Error  [out] 粒子毎の局所誤差の推定値(セル数単位) (NULLの時は格納しない)
+    //! 他の引数はSoA版のRKG()と同じ
+    static int Integrate(const IntegratorType& Type, const DSlib::DataBlock&DataBlock, const double t_step, const int& NumParticles, POSITION_TYPE* x_i, POSITION_TYPE* y_i, POSITION_TYPE* z_i, const double& Theta0 = 1.0, const double& dTheta = 0.0, double* Error = NULL);
+
+    //! @brief 1ステップあたりの流速の評価回数を返す
+    static int GetNumStages(const IntegratorType& Type);
+
+    //! @brief 積分法の次数を返す
+    //! 埋め込み型では局所誤差の推定値がステップ幅のこの値乗に比例する
+    static int GetOrder(const IntegratorType& Type);
+
+    //! @brief 局所誤差の推定値を計算できる(埋め込み型の)積分法かどうかを返す
+    static bool IsEmbedded(const IntegratorType& Type)
+    {
+        return Type == INTEGRATOR_DOPRI54;
+    }
+
+    //! @brief 積分法の名前を返す
+    static const char* GetName(const IntegratorType& Type);
 };
 } // namespace PPlib
 #endif
\ No newline at end of file
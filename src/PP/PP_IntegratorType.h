@@ -0,0 +1,24 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef PPLIB_P_P__INTEGRATOR_TYPE_H
+#define PPLIB_P_P__INTEGRATOR_TYPE_H
+
+namespace PPlib
+{
+//! 粒子の移動計算に使う時間積分法
+enum IntegratorType
+{
+    INTEGRATOR_EULER,  //!< 前進オイラー法 (1次, 1段)
+    INTEGRATOR_RK2,    //!< ホイン法 (2次, 2段)
+    INTEGRATOR_RKG,    //!< ルンゲ=クッタ=ギル法 (4次, 4段) 従来からの既定値
+    INTEGRATOR_DOPRI54 //!< ドルマン=プリンス法 (5次, 7段) 4次の解との差を局所誤差の推定値とする
+};
+} // namespace PPlib
+#endif
@@ -11,12 +11,15 @@
 #define PPLIB_PP_TRANSPORT_H
 
 #include <iostream>
+#include "LPT_PositionType.h"
 
 #include <vector>
 #include <list>
 #include "LPT_LogOutput.h"
 #include "Interpolator.h"
+#include "PP_Integrator.h"
 #include "DataBlock.h"
+#include "SuspendedParticles.h"
 //forward declaration
 namespace DSlib
 {
@@ -31,9 +34,13 @@ class ParticleData;
 class PP_Transport
 {
 public:
-    PP_Transport(const PP_Transport& obj) : num_called(0), counter(0), LoadedDataBlock(NULL){}
+    PP_Transport(const PP_Transport& obj) : LoadedDataBlock(NULL), num_called(0), counter(0), num_advanced(0), num_substeps(0), CourantNumber(obj.CourantNumber), Integrator(obj.Integrator), Tolerance(obj.Tolerance){}
 
-    PP_Transport() : num_called(0), counter(0), LoadedDataBlock(NULL){}
+    PP_Transport() : LoadedDataBlock(NULL), num_called(0), counter(0), num_advanced(0), num_substeps(0), CourantNumber(-1.0), Integrator(INTEGRATOR_RKG), Tolerance(-1.0){}
+
+    //! @brief 粒子毎にサブステップ数を決めるモードで使うコンストラクタ
+    //! @param arg_CourantNumber [in] サブステップ1回あたりに粒子が移動するセル数の上限 (0以下の時は常にdivT分割する)
+    explicit PP_Transport(const double& arg_CourantNumber) : LoadedDataBlock(NULL), num_called(0), counter(0), num_advanced(0), num_substeps(0), CourantNumber(arg_CourantNumber), Integrator(INTEGRATOR_RKG), Tolerance(-1.0){}
 
     ~PP_Transport()
     {
@@ -50,13 +57,110 @@ public:
     //! @retval 5 計算済だった
     //! 返り値が1の時は呼び出し元で粒子オブジェクトを削除する
     //! 返り値が2の時は呼び出し元でコンテナからの削除&再挿入を行う
-    //! 返り値が3の時は通信完了後に再計算を行う
+    //! 返り値が3の時はSuspendedに中断した時点の状態を格納するので、移動先のデータブロックの到着後にResume()で計算を再開する
     //! 返り値が4の時は計算終了とみなすので、呼出し元での処理は0と同じ
-    int Calc(ParticleData* Particle, const double& deltaT, const int& divT, const double& CurrentTime, const int& CurrentTimeStep);
+    //! CourantNumberが正の値の時は、divTを上限として粒子位置の流速からサブステップ数を粒子毎に決める
+    //! @param Suspended [out] 返り値が3の時に中断した時点の状態を格納する (NULLの時は格納しない)
+    int Calc(ParticleData* Particle, const double& deltaT, const int& divT, const double& CurrentTime, const int& CurrentTimeStep, SuspendedParticle* Suspended = NULL);
+
+    //! @brief 未着のデータブロックへ移動して中断した粒子の計算を、中断したサブステップから再開する
+    //! @param State [inout] Calc()またはResume()が格納した状態 返り値が3の時は新たに中断した時点の状態で上書きする
+    //! @return Calc()と同じ
+    int Resume(SuspendedParticle* State, const double& CurrentTime, const int& CurrentTimeStep);
+
+    //! @brief 再開先のデータブロックが届かなかった粒子の計算を、中断した時点の座標で終了する
+    //!
+    //! 未要求のデータブロックに移動した時(Calc()の返り値が4の時)と同様に、中断した時点の座標と再開先のBlockIDを
+    //! このタイムステップでの移動後の値とする。残りのサブステップ分は移動しない
+    void Finish(const SuspendedParticle& State, const double& CurrentTime, const int& CurrentTimeStep);
+
+    //! @brief 同じデータブロック内に存在する粒子の移動をまとめて計算する
+    //!
+    //! PP_Integrator::BatchSize個ずつSoA形式に詰めて、補間とルンゲ=クッタ積分をベクトル化して計算する
+    //! サブステップの途中でブロック外に出た粒子、および別のブロックへ移動した粒子は
+    //! その時点からCalc()と同じ1粒子ずつの計算に切り替える
+    //! @param Particles [in]  計算対象の粒子 (全て同じBlockIDを持つこと)
+    //! @param RetVals   [out] Particlesと同じ順に格納した、粒子毎のCalc()と同じ意味の返り値
+    //! @param Suspended [out] Particlesと同じ順に格納した、返り値が3の粒子の中断時の状態 (NULLの時は格納しない)
+    void CalcBatch(const std::vector<ParticleData*>& Particles, std::vector<int>* RetVals, const double& deltaT, const int& divT, const double& CurrentTime, const int& CurrentTimeStep, std::vector<SuspendedParticle>* Suspended = NULL);
+
+    //! @brief 同じデータブロック内に存在する粒子を、粒子が存在するセルのMorton順に並べ替える
+    //!
+    //! 連続して計算する粒子が同じセル付近の流速データを参照するようにして、補間時のキャッシュの再利用率を上げる
+    //! 前回並べ替えた順序からあまり変わっていない時は挿入ソートで並べ替えるので、毎タイムステップ呼び出しても良い
+    //! 粒子オブジェクトのアドレスとlistの順序は変えずに、オブジェクトの中身を入れ替える
+    //! @param Particles    [inout] 並べ替える粒子 (全て同じBlockIDを持つこと)
+    //! @param MinParticles [in]    粒子数がこの値未満の時は並べ替えない
+    //! @return 並べ替えで位置が変わった粒子があればtrue
+    bool SortByMortonOrder(std::list<ParticleData*>* Particles, const size_t& MinParticles);
+
+    //! @brief 移動計算に使う積分法を設定する
+    //! @param Type          [in] 積分法
+    //! @param arg_Tolerance [in] 1サブステップあたりの局所誤差の許容値(セル数単位)
+    //! Typeが埋め込み型でarg_Toleranceが正の値の時は、divTを上限として局所誤差の推定値からサブステップ数を粒子毎に決める
+    //! CourantNumberによるサブステップ数の調整と併用した時は、両者の大きい方を使う
+    void SetIntegrator(const IntegratorType& Type, const double& arg_Tolerance)
+    {
+        Integrator = Type;
+        Tolerance  = arg_Tolerance;
+    }
+
+    //! @brief これまでに移動計算を終えた粒子数を返す
+    long GetNumAdvanced() const
+    {
+        return num_advanced;
+    }
+
+    //! @brief これまでに移動計算を終えた粒子のサブステップ数の合計を返す
+    long GetNumSubSteps() const
+    {
+        return num_substeps;
+    }
 
 private:
+    //! @brief t_begin番目のサブステップから粒子の移動を計算し、粒子データを更新する
+    //! @param Particle [in]    計算対象の粒子
+    //! @param x_new    [inout] 粒子座標
+    //! @param x_i      [inout] 粒子座標(データブロック内のローカル座標) t_beginがnumTの時は直前のサブステップでの値を渡すこと
+    //! @param t_begin  [in]    計算を開始するサブステップ
+    //! @param dt       [in]    サブステップの時間刻み
+    //! @param numT     [in]    サブステップ数
+    //! @param Suspended [out] 返り値が3の時に中断した時点の状態を格納する (NULLの時は格納しない)
+    //! @return Calc()と同じ
+    int Advance(ParticleData* Particle, POSITION_TYPE x_new[3], POSITION_TYPE x_i[3], const int& t_begin, const double& dt, const int& numT, const double& CurrentTime, const int& CurrentTimeStep, SuspendedParticle* Suspended);
+
+    //! @brief 粒子位置での流速とセル幅からサブステップ数を決める
+    //! @param v       [in] 粒子位置での流速
+    //! @param Pitch   [in] 粒子が存在するデータブロックのセル幅
+    //! @param deltaT  [in] 1タイムステップの時間積分幅
+    //! @param MaxNumT [in] サブステップ数の上限
+    //! @return 1サブステップで移動するセル数がCourantNumber以下となる最小のサブステップ数(1以上MaxNumT以下)
+    int DecideNumSubSteps(const REAL_TYPE v[3], const REAL_TYPE Pitch[3], const double& deltaT, const int& MaxNumT) const;
+
+    //! @brief deltaT/MaxNumTの幅で1ステップ積分した時の局所誤差の推定値からサブステップ数を決める
+    //! @param Error   [in] 局所誤差の推定値(セル数単位)
+    //! @param MaxNumT [in] サブステップ数の上限
+    //! @return 局所誤差の推定値がTolerance以下となる最小のサブステップ数(1以上MaxNumT以下)
+    int DecideNumSubStepsByError(const double& Error, const int& MaxNumT) const;
+
+    //! @brief 局所誤差によるサブステップ数の調整を行なうかどうかを返す
+    bool ErrorControl() const
+    {
+        return Tolerance > 0.0 && PP_Integrator::IsEmbedded(Integrator);
+    }
+
+    //! @brief 計算を終えた粒子のサブステップ数を集計する
+    void CountSubSteps(const int& numT)
+    {
+        num_advanced++;
+        num_substeps += numT;
+    }
+
+    //! @brief CalcBatch()のa番目のレーンをlast番目のレーンの値で上書きする
+    static void RemoveLane(const int& a, const int& last, POSITION_TYPE x_g[][PP_Integrator::BatchSize], POSITION_TYPE x_l[][PP_Integrator::BatchSize], size_t* Index);
+
     //! @brief 粒子データの時刻、タイムステップ、座標を更新する
-    void UpdateParticle(ParticleData* Particle, const double& CurrentTime, const int& CurrentTimeStep, REAL_TYPE* Coord);
+    void UpdateParticle(ParticleData* Particle, const double& CurrentTime, const int& CurrentTimeStep, POSITION_TYPE* Coord);
 
     //! @brief 現在計算に使っているデータブロックへのポインタ
     DSlib::DataBlock* LoadedDataBlock;
@@ -67,6 +171,21 @@ private:
 
     //! @brief Calc()の最後の段階で未着のデータブロックに移動したために、粒子速度が不正確な値となっている粒子の数
     long counter;
+
+    //! @brief 移動計算を終えた粒子数
+    long num_advanced;
+
+    //! @brief 移動計算を終えた粒子のサブステップ数の合計
+    long num_substeps;
+
+    //! @brief サブステップ1回あたりに粒子が移動するセル数の上限 (0以下の時は粒子毎のサブステップ数の調整を行なわない)
+    double CourantNumber;
+
+    //! @brief 移動計算に使う積分法
+    IntegratorType Integrator;
+
+    //! @brief 1サブステップあたりの局所誤差の許容値 (0以下の時は局所誤差によるサブステップ数の調整を行なわない)
+    double Tolerance;
 };
 } // namespace PPlib
 #endif
\ No newline at end of file
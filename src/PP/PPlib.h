@@ -31,7 +31,7 @@ class PPlib
 {
 private:
     //Singletonパターンを適用
-    PPlib(){}
+    PPlib() : NumActiveProcs(-1){}
     PPlib(const PPlib& obj);
     PPlib& operator=(const PPlib& obj);
     ~PPlib()
@@ -77,22 +77,224 @@ public:
     bool isExpired(const double& CurrentTime, T* obj);
 
     //! @brief  粒子のマイグレーションが必要かどうか判定する
-    void DetermineMigration();
+    //!
+    //! 全粒子計算プロセスの粒子数と粒子計算時間を集めて、最大値/平均値の比を負荷の不均衡度とする
+    //! 集めた値はMigrateParticle()で使うので保持しておく
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param CalcTime  [in] 直前の粒子計算に要した時間
+    //! @param Threshold [in] 粒子数または計算時間の不均衡度がこの値を越えたらマイグレーションが必要と判定する
+    //! @retval true  マイグレーションが必要
+    //! @retval false マイグレーションは不要
+    bool DetermineMigration(const double& CalcTime, const float& Threshold);
 
     //! @brief 粒子のマイグレーションを行なう
+    //!
+    //! DetermineMigration()で集めた負荷の情報を元に、平均より負荷の大きいプロセスから
+    //! 平均より負荷の小さいプロセスへ粒子を送る。
+    //! 送信する粒子はなるべくブロック単位でまとめて選ぶ
+    //! comm_p内の全プロセスから呼び出すこと
     void MigrateParticle();
 
-    //!  引数で指定されたプロセス数を目標に、開始点のデータ分散を行なう
+    //! @brief BlockIDの範囲毎に粒子を担当するモードを開始する
+    //!
+    //! BlockIDの値域を連続した範囲に分割し、comm_p内の各プロセスに1つずつ割り当てる
+    //! 範囲の境界は開始点の格子点数が均等になるように決め、開始点が無い場合は値域を等分する
+    //! 開始点の分散後にcomm_p内の全プロセスから呼び出すこと
+    //! @param NumBlockIDs [in] BlockIDの取り得る値の上限(最大値+1)
+    void InitializeOwnership(const long& NumBlockIDs);
+
+    //! BlockIDの範囲毎に粒子を担当するモードかどうかを返す
+    bool is_ownership_enabled(void)
+    {
+        return !OwnershipBoundary.empty();
+    }
+
+    //! @brief 指定されたBlockIDを担当するプロセスのRank番号(comm_p内)を返す
+    //!
+    //! BlockIDが負の値(計算領域外)の場合は自Rankを返す
+    int FindOwner(const long& BlockID);
+
+    //! @brief 担当範囲外のブロックに存在する粒子を、そのブロックを担当するプロセスへ送る
+    //! comm_p内の全プロセスから呼び出すこと
+    void HandOffParticles();
+
+    //! @brief 稼働中(開始点または粒子の担当を割り当てる)の粒子計算プロセス数を返す
+    //!
+    //! comm_p内のRank 0からGetNumActiveProcs()-1までが稼働中のプロセスとなる
+    int GetNumActiveProcs(void);
+
+    //! @brief 稼働中の粒子計算プロセス数を設定する
+    //!
+    //! 設定しなかった場合はcomm_p内の全プロセスが稼働中として扱われる
+    void SetNumActiveProcs(const int& NumProcs)
+    {
+        NumActiveProcs = NumProcs;
+    }
+
+    //! @brief 稼働中のプロセスあたりの粒子数が閾値を越えていたら稼働プロセス数を増やす
+    //!
+    //! 稼働プロセス数は倍増、または平均粒子数が閾値以下になる数まで増やし
+    //! 開始点は全稼働プロセスで負荷が均等になるように再配置し、粒子はマイグレーションで新たに稼働したプロセスへ送る
+    //! 開始点は分割せずに移動するので、開始点のIDと放出済の粒子IDは変わらない
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param MaxParticlesPerProc [in] 稼働中のプロセスあたりの平均粒子数の閾値
+    //! @param CalcTime            [in] 直前の粒子計算に要した時間
+    //! @retval true  稼働プロセス数を増やした
+    //! @retval false 稼働プロセス数は変わらない
+    bool GrowActiveProcs(const int& MaxParticlesPerProc, const double& CalcTime);
+
+    //! @brief 全プロセスの開始点を集めて、指定されたプロセス数で負荷が均等になるように割り当て直す
+    //!
+    //! 開始点は分割せずに移動するので、開始点のIDと放出済の粒子IDは変わらない
+    //! comm_p内の全プロセスから呼び出すこと
+    //! 集めた開始点は全プロセスで同一なので、復元に失敗した場合は全プロセスが0以外を返す
+    //! @param NParticleProcs [in] 開始点を担当するプロセス数
+    //! @retval 0 正常終了
+    //! @retval 1 開始点の復元に失敗した
+    int ReassignStartPoints(const int& NParticleProcs);
+
+    //! @brief 各プロセスが持つ粒子データの配列を稼働中のプロセスへ分配して、Particlesに登録する
+    //!
+    //! UseOwnershipがtrueの時は粒子数を重みとしてBlockIDの担当範囲を決め(InitializeOwnership()の代わりになる)、各粒子を担当プロセスへ送る
+    //! falseの時は全粒子をBlockID順に並べて稼働中のプロセスに同数ずつ割り当てる
+    //! 分配後の粒子数の最大値と平均値の比をログに出力する
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param Records      [in] 自プロセスが持つ粒子データ (BlockIDは設定済であること)。呼び出し後は空になる
+    //! @param UseOwnership [in] BlockIDの範囲毎に粒子を担当するモードで分配するかどうかのフラグ
+    //! @param NumBlockIDs  [in] BlockIDの取り得る値の上限(最大値+1)
+    //! @return 受信した粒子数
+    size_t DistributeParticles(std::vector<ParticleData>& Records, const bool& UseOwnership, const long& NumBlockIDs);
+
+    //! @brief 引数で指定されたプロセス数を目標に、開始点のデータ分散を行なう
+    //!
+    //! IDが設定済の開始点(WriteDistributedStartPoints()で出力したファイルから読み込んだもの)は分割せず、IDも変更しない
     void DistributeStartPoints(const int& NParticleProcs);
 
+    //! @brief 開始点から放出される粒子数の予測値を負荷として、開始点のデータ分散を行なう
+    //!
+    //! 各開始点の負荷をStartPoint::EstimateNumResidentParticles()で見積り、平均負荷を越える開始点を分割した後
+    //! 負荷の大きい順に、その時点で最も負荷の小さいプロセスへ割り当てる(LPTアルゴリズム)
+    //! UseMeasuredLoadがtrueの時は、Particlesに登録されている粒子数を開始点毎に集計した値で予測値を補正する
+    //! IDが設定済の開始点は分割せず、IDも変更しない。粒子数の集計はこのIDで粒子と対応付けて行なう
+    //! @param NParticleProcs  [in] 開始点を担当するプロセス数
+    //! @param Horizon         [in] 寿命の指定が無い粒子の負荷を見積もる期間 (0以下の時は開始点に指定された寿命、放出期間の最大値を用いる)
+    //! @param UseMeasuredLoad [in] 実測した粒子数で負荷を補正するかどうかのフラグ(trueの時はcomm_p内の全プロセスから呼び出すこと)
+    void DistributeStartPointsByCost(const int& NParticleProcs, const double& Horizon, const bool& UseMeasuredLoad);
+
+    //! @brief 粒子データの配列を複製してParticlesに登録する
+    //!
+    //! BlockIDが同じ粒子が連続する範囲毎にlistにまとめて登録するので、BlockID順に並んだ配列を渡すと
+    //! ロックを取る回数はブロック数と同じになる。範囲毎の粒子オブジェクトの確保はスレッド並列に行なう
+    //! @param Records    [in] 登録する粒子データ (BlockIDは設定済であること)
+    //! @param NumRecords [in] Recordsの要素数
+    void InsertParticles(const ParticleData* Records, const size_t& NumRecords);
+
     //!開始点の格子座標をTimeStep0、時刻0.0 の粒子として出力する
     void OutputStartPoints(const REAL_TYPE& RefLength);
 
     //! ファイルから開始点情報を読み込む
     void ReadStartPoints(const std::string& filename, const REAL_TYPE& RefLength, const double& RefTime);
 
+    //! 入力ストリームからWriteStartPoints()と同じ形式の開始点情報を読み込む
+    void ReadStartPoints(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
+
     //! ファイルに開始点情報を出力する
     void WriteStartPoints(const std::string& filename, const REAL_TYPE& RefLength, const double& RefTime);
+
+    //! @brief 全Rankが担当する開始点をRank0に集めてファイルに出力する
+    //!
+    //! 開始点の分散とIDの設定が終わった後に呼び出し、リスタート時にはReadStartPoints()またはDistributeStartPointsFromFile()で読み込んだ開始点を
+    //! 分割せずIDもそのまま使うことで、リスタート前後で開始点と粒子のIDの対応を保つ
+    //! バイナリ形式の時は無次元のままWriteStartPointsBinary()の形式で出力し、開始点毎の担当Rankも記録する
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param Binary [in] WriteStartPointsBinary()の形式で出力するかどうかのフラグ (trueの時はRefLength, RefTimeは使わない)
+    //! @retval 0 正常終了
+    int WriteDistributedStartPoints(const std::string& filename, const REAL_TYPE& RefLength, const double& RefTime, const bool& Binary = false);
+
+    //! @brief 開始点をバイナリ形式でBufferの末尾に追加する
+    //!
+    //! 開始点毎に 種類(int), 格子点数(int), 本体の大きさ(unsigned long) のレコードヘッダを付けて
+    //! StartPoint::WriteBinary()の出力を並べる。座標と時刻は無次元のまま、IDと放出状態も含めて出力する
+    static void PackStartPoints(const std::vector<StartPoint*>& Points, std::string* Buffer);
+
+    //! @brief PackStartPoints()の出力から開始点を復元してStartPointsに追加する
+    //! @param Data [in] 読み込むデータの先頭
+    //! @param Size [in] データの大きさ(byte)
+    //! @retval 0 正常終了 (データが壊れていた場合は、そのレコード以降を読み込まずに0以外を返す)
+    int UnpackStartPoints(const char* Data, const size_t& Size);
+
+    //! @brief 開始点を並列読み込み用のバイナリファイルに出力する
+    //!
+    //! ヘッダ、PackStartPoints()と同じ形式のレコード、レコード毎のファイル内オフセットと格子点数の累積値の索引を順に出力する
+    //! MaxNumStartPointsが正の値の場合は、それを越える開始点を分割してから出力する
+    //! RankFirstRecordsが指定された場合は、その後に担当Rank毎の先頭レコード番号の索引を出力する (開始点を分割する時は出力しない)
+    //! @param filename          [in] 出力するファイル名
+    //! @param MaxNumStartPoints [in] 1レコードあたりの格子点数の上限
+    //! @param RankFirstRecords  [in] Rank毎の先頭の開始点の番号 (Rank数+1要素で、末尾の要素は開始点の数)
+    //! @retval 0 正常終了
+    int WriteStartPointsBinary(const std::string& filename, const int& MaxNumStartPoints, const std::vector<unsigned long>* RankFirstRecords = NULL);
+
+    //! @brief WriteStartPointsBinary()で出力したファイルから自Rankが担当する開始点だけを読み込む
+    //!
+    //! ファイルに担当Rankの索引があり、出力時の担当Rankが全てNParticleProcs未満の時は出力時と同じRankのレコードを担当する
+    //! それ以外の時は、格子点の通し番号を開始点を担当するプロセス数で等分し、先頭の格子点が自Rankの範囲に入るレコードを担当する
+    //! 各プロセスは索引と担当するレコードの範囲だけを読むので、ファイル全体を読み込んだり分割したりはしない
+    //! 読み込んだ開始点はStartPointsの末尾に追加し、IDが設定されていない開始点には既存の開始点の続きの番号を設定する
+    //! @param filename       [in] 読み込むファイル名
+    //! @param NParticleProcs [in] 開始点を担当するプロセス数
+    //! @retval 0 正常終了
+    int DistributeStartPointsFromFile(const std::string& filename, const int& NParticleProcs);
+
+private:
+    //! @brief 全Rankが担当する開始点をRank0に集める
+    //!
+    //! Rank0では自Rankの開始点をMyStartPointsに退避し、全Rankの開始点をRank順にStartPointsに復元する
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param MyStartPoints    [out] Rank0のみ、退避した自Rankの開始点
+    //! @param RankFirstRecords [out] Rank0のみ、Rank毎の先頭の開始点の番号 (Rank数+1要素)
+    //! @retval 0 正常終了
+    int GatherStartPoints(std::vector<StartPoint*>* MyStartPoints, std::vector<unsigned long>* RankFirstRecords);
+
+    //! @brief 送信先のRank毎に振り分けた粒子を送受信する
+    //!
+    //! 送信した粒子オブジェクトはdeleteし、受信した粒子はBlockID毎にまとめてParticlesに登録する
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param SendParticles [in] 送信先のRank(comm_p内)毎の送信する粒子。同じBlockIDの粒子は連続して格納されていること
+    //! @return 受信した粒子数
+    size_t ExchangeParticles(std::vector<std::vector<ParticleData*> >& SendParticles);
+
+    //! @brief 送信先のRank毎に連続して並べた粒子データを送受信し、受信した粒子をParticlesに登録する
+    //! comm_p内の全プロセスから呼び出すこと
+    //! @param SendBuff   [in] 送信する粒子データ。送信後に解放する
+    //! @param SendCounts [in] 送信先のRank(comm_p内)毎の粒子数
+    //! @return 受信した粒子数
+    size_t ExchangeRecords(std::vector<ParticleData>& SendBuff, const std::vector<int>& SendCounts);
+
+    //! @brief BlockID毎の重みを全プロセスで合計し、重みが均等になるように担当範囲の境界を決める
+    //! @param Weights     [in] 自プロセスが持つBlockID毎の重み
+    //! @param NumBlockIDs [in] BlockIDの取り得る値の上限(最大値+1)
+    void DecideOwnershipBoundary(const std::map<long, double>& Weights, const long& NumBlockIDs);
+
+    //! @brief 開始点毎の負荷(同時に存在する粒子数の予測値)を計算する
+    //! @param Points  [in]  開始点
+    //! @param Horizon [in]  寿命の指定が無い粒子の負荷を見積もる期間 (0以下の時は開始点に指定された寿命、放出期間の最大値を用いる)
+    //! @param Costs   [out] Pointsと同じ順に格納した負荷の予測値
+    void EstimateStartPointCosts(const std::vector<StartPoint*>& Points, const double& Horizon, std::vector<double>* Costs);
+
+    //! @brief 開始点を負荷の大きい順に、その時点で最も負荷の小さいプロセスへ割り当てる
+    //!
+    //! 自Rankに割り当てられた開始点はStartPointsに追加し、それ以外は破棄する
+    //! @param Candidates     [in] 負荷と開始点の組
+    //! @param NParticleProcs [in] 開始点を割り当てるプロセス数
+    //! @return 割り当て後の負荷の最大値
+    double AssignStartPoints(const std::vector<std::pair<double, StartPoint*> >& Candidates, const int& NParticleProcs);
+
+    int NumActiveProcs; //!< 稼働中の粒子計算プロセス数 (0以下の時はcomm_p内の全プロセス)
+
+    std::vector<long> OwnershipBoundary; //!< OwnershipBoundary[i]からOwnershipBoundary[i+1]-1までのBlockIDをRank iが担当する
+
+    std::vector<long>   NumParticlesAll; //!< DetermineMigration()で集めた各プロセスの粒子数
+    std::vector<double> CalcTimeAll;     //!< DetermineMigration()で集めた各プロセスの粒子計算時間
 };
 } // namespace PPlib
 #endif
\ No newline at end of file
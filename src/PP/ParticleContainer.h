@@ -11,6 +11,7 @@
 #define PARTICLE_CONTAINER_H
 #include <map>
 #include <list>
+#include <vector>
 #include <omp.h>
 #include "LPT_LogOutput.h"
 #include "ParticleContainerIterator.h"
@@ -26,7 +27,7 @@ class ParticleContainer
     ParticleContainer& operator=(const ParticleContainer& obj);
 
 public:
-    ParticleContainer()
+    ParticleContainer() : NumParticles(0)
     {
         omp_init_lock(&ParticleContainerLock);
     }
@@ -39,55 +40,105 @@ public:
     void insert(ParticleData* particle)
     {
         omp_set_lock(&ParticleContainerLock);
-        std::map<int, std::list<ParticleData*>*>::iterator it = id_table.find(particle->BlockID);
+        std::map<long, ParticleBucket>::iterator it = id_table.find(particle->BlockID);
         if(it != id_table.end())
         {
-            it->second->push_back(particle);
+            it->second.Particles->push_back(particle);
+            ++(it->second.NumParticles);
         }else{
-            std::list<ParticleData*>* tmp = new std::list<ParticleData*>;
-            tmp->push_back(particle);
+            ParticleBucket tmp;
+            tmp.Particles    = new std::list<ParticleData*>;
+            tmp.Particles->push_back(particle);
+            tmp.NumParticles = 1;
             id_table.insert(std::make_pair(particle->BlockID, tmp));
         }
+        ++NumParticles;
         omp_unset_lock(&ParticleContainerLock);
     }
 
     //! コンテナに、引数で渡された粒子のリストを追加する
     //
+    //! 渡されたlistはコンテナが管理するので、呼び出し側で参照、deleteしてはならない
     //! @attention 同一リスト内の粒子は全て同じBloackIDを持つものでなければならないが
     //!            パフォーマンス上の理由により、同一Blockに所属するかどうかのチェックはしていないので注意
     void insert(std::list<ParticleData*>* particles)
     {
-        if(particles == NULL || particles->empty())return;
+        if(particles == NULL)return;
+        if(particles->empty())
+        {
+            delete particles;
+            return;
+        }
 
+        //std::list::size()はO(N)なのでロックの外で数えておく
+        size_t     num_inserted = particles->size();
+        const long BlockID      = particles->front()->BlockID;
         omp_set_lock(&ParticleContainerLock);
         LPT::LPT_LOG::GetInstance()->LOG("particles = ", particles);
-        std::map<int, std::list<ParticleData*>*>::iterator it = id_table.find(particles->front()->BlockID);
+        std::map<long, ParticleBucket>::iterator it = id_table.find(BlockID);
         if(it != id_table.end())
         {
             LPT::LPT_LOG::GetInstance()->LOG("add to existing list");
-            it->second->splice(it->second->end(), *particles);
+            it->second.Particles->splice(it->second.Particles->end(), *particles);
+            it->second.NumParticles += num_inserted;
+            delete particles;
         }else{
             LPT::LPT_LOG::GetInstance()->LOG("insert new list:");
-            id_table.insert(std::make_pair(particles->front()->BlockID, particles));
+            ParticleBucket tmp;
+            tmp.Particles    = particles;
+            tmp.NumParticles = num_inserted;
+            id_table.insert(std::make_pair(BlockID, tmp));
         }
+        NumParticles += num_inserted;
         omp_unset_lock(&ParticleContainerLock);
     }
 
     //! コンテナに登録されている粒子データの数を返す
-    int size(void)
+    //
+    //! 粒子数はinsert/erase/find時に更新しているので、ここではロックを取って保持している値を返すだけ
+    size_t size(void)
+    {
+        omp_set_lock(&ParticleContainerLock);
+        size_t rt = NumParticles;
+        omp_unset_lock(&ParticleContainerLock);
+        return rt;
+    }
+
+    //! 指定されたBlockIDに登録されている粒子データの数を返す
+    size_t count(const long& BlockID)
+    {
+        size_t rt = 0;
+        omp_set_lock(&ParticleContainerLock);
+        std::map<long, ParticleBucket>::iterator it = id_table.find(BlockID);
+        if(it != id_table.end())
+        {
+            rt = it->second.NumParticles;
+        }
+        omp_unset_lock(&ParticleContainerLock);
+        return rt;
+    }
+
+    //! ブロック毎の粒子数のスナップショットを返す
+    //
+    //! BlockIDの昇順に(BlockID, 粒子数)の組を格納する
+    //! キャッシュ、スケジューラ、負荷分散などから粒子を走査せずにブロック毎の粒子数を参照するためのもの
+    //! find()で取り出されて計算中のブロックの粒子は含まれないので注意
+    void GetOccupancy(std::vector<std::pair<long, size_t> >* Occupancy)
     {
-        int sum_size = 0;
-        for(std::map<int, std::list<ParticleData*>*>::iterator it = id_table.begin(); it != id_table.end(); ++it)
+        omp_set_lock(&ParticleContainerLock);
+        Occupancy->clear();
+        Occupancy->reserve(id_table.size());
+        for(std::map<long, ParticleBucket>::iterator it = id_table.begin(); it != id_table.end(); ++it)
         {
-            sum_size += (*it).second->size();
+            Occupancy->push_back(std::make_pair(it->first, it->second.NumParticles));
         }
-        return sum_size;
+        omp_unset_lock(&ParticleContainerLock);
     }
 
     //! コンテナの先頭を指すイテレータを返す
     iterator begin(void)
     {
-        return id_table.empty() ? ParticleContainerIterator(this) : ParticleContainerIterator(this, id_table.begin(), (*id_table.begin()).second->begin());
+        return id_table.empty() ? ParticleContainerIterator(this) : ParticleContainerIterator(this, id_table.begin(), (*id_table.begin()).second.Particles->begin());
     }
 
     //! コンテナの末尾+1を指すイテレータを返す
@@ -97,21 +148,21 @@ public:
     }
 
     //! 指定されたBlockIDの粒子データオブジェクトが登録されている範囲を返す
-    std::pair<iterator, iterator>equal_range(const int& BlockID)
+    std::pair<iterator, iterator>equal_range(const long& BlockID)
     {
         std::pair<iterator, iterator> rt = make_pair(ParticleContainerIterator(this), ParticleContainerIterator(this));
 
         omp_set_lock(&ParticleContainerLock);
-        std::map<int, std::list<ParticleData*>*>::iterator it = id_table.find(BlockID);
+        std::map<long, ParticleBucket>::iterator it = id_table.find(BlockID);
         if(it != id_table.end())
         {
-            std::map<int, std::list<ParticleData*>*>::iterator next = it;
+            std::map<long, ParticleBucket>::iterator next = it;
             ++next;
             if(next != id_table.end())
             {
-                rt = make_pair(ParticleContainerIterator(this, it, (*it).second->begin()), ParticleContainerIterator(this, next, (*next).second->begin()));
+                rt = make_pair(ParticleContainerIterator(this, it, (*it).second.Particles->begin()), ParticleContainerIterator(this, next, (*next).second.Particles->begin()));
             }else{
-                rt = make_pair(ParticleContainerIterator(this, it, (*it).second->begin()), ParticleContainerIterator(this));
+                rt = make_pair(ParticleContainerIterator(this, it, (*it).second.Particles->begin()), ParticleContainerIterator(this));
             }
         }
         omp_unset_lock(&ParticleContainerLock);
@@ -121,14 +172,15 @@ public:
     //! 指定されたBlockIDの粒子データオブジェクトが登録されているlistを返す
     //
     //ここで渡したlistはテーブルから削除される
-    std::list<ParticleData*>* find(const int& BlockID)
+    std::list<ParticleData*>* find(const long& BlockID)
     {
-        std::list<ParticleData*>* rt                          = NULL;
+        std::list<ParticleData*>* rt             = NULL;
         omp_set_lock(&ParticleContainerLock);
-        std::map<int, std::list<ParticleData*>*>::iterator it = id_table.find(BlockID);
+        std::map<long, ParticleBucket>::iterator it = id_table.find(BlockID);
         if(it != id_table.end())
         {
-            rt = (*it).second;
+            rt            = (*it).second.Particles;
+            NumParticles -= (*it).second.NumParticles;
             id_table.erase(it);
         }
         omp_unset_lock(&ParticleContainerLock);
@@ -143,8 +195,11 @@ public:
         omp_set_lock(&ParticleContainerLock);
         ParticleContainer::iterator after = it_particle;
         ++after;
-        (*it_particle.map_iterator).second->erase(it_particle.list_iterator);
-        if((*it_particle.map_iterator).second->empty())
+        ParticleBucket& bucket = (*it_particle.map_iterator).second;
+        bucket.Particles->erase(it_particle.list_iterator);
+        --(bucket.NumParticles);
+        --NumParticles;
+        if(bucket.Particles->empty())
         {
             id_table.erase(it_particle.map_iterator);
         }
@@ -153,8 +208,11 @@ public:
     }
 
 private:
-    //ブロックIDとそのIDに含まれる粒子データを格納するlistへのポインタを保持するテーブル
-    std::map<int, std::list<ParticleData*>*> id_table;
+    //ブロックIDとそのIDに含まれる粒子データを格納するlistへのポインタおよび粒子数を保持するテーブル
+    std::map<long, ParticleBucket> id_table;
+
+    //コンテナに登録されている粒子データの総数
+    size_t NumParticles;
 
     //GetRange()で該当するブロックIDが未登録だった時に返す値に使うダミーのlist
     std::list<ParticleData*> dummy_list;
@@ -12,12 +12,23 @@
 #include <iterator>
 #include <map>
 #include <list>
+#include <cstddef>
 
 namespace PPlib
 {
 //forward declaration
 class ParticleContainer;
 class ParticleData;
+
+//! @brief ParticleContainer::id_tableの要素
+//!
+//! 1つのブロックに含まれる粒子データのlistと、その要素数(std::list::size()はO(N)なので別に保持する)
+struct ParticleBucket
+{
+    std::list<ParticleData*>* Particles;
+    size_t                    NumParticles;
+};
+
 //! ParticleContanier classのiterator
 //
 //ParticleContainer::id_tableが持っているlistのイテレータを操作して返すだけ
@@ -29,7 +40,7 @@ class ParticleContainerIterator: public std::iterator<std::forward_iterator_tag,
     ParticleContainerIterator(ParticleContainer* arg);
 
     // 指定された値でiteratorも初期化するコンストラクタ
-    ParticleContainerIterator(ParticleContainer* arg, std::map<int, std::list<ParticleData*>*>::iterator arg_map_iterator, std::list<ParticleData*>::iterator arg_list_iterator);
+    ParticleContainerIterator(ParticleContainer* arg, std::map<long, ParticleBucket>::iterator arg_map_iterator, std::list<ParticleData*>::iterator arg_list_iterator);
 
 public:
     ParticleContainerIterator(const ParticleContainerIterator& arg);
@@ -42,10 +53,10 @@ public:
     bool operator!=(const ParticleContainerIterator& iterator);
 
 private:
-    std::map<int, std::list<ParticleData*>*>::iterator map_iterator;
+    std::map<long, ParticleBucket>::iterator           map_iterator;
     std::list<ParticleData*>::iterator list_iterator;
     ParticleContainer*                                 container;
-    static std::map<int, std::list<ParticleData*>*>    map_dummy;
+    static std::map<long, ParticleBucket>              map_dummy;
     static std::list<ParticleData*>                    list_dummy;
 
     friend ParticleContainer;
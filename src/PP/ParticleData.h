@@ -17,6 +17,8 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <cstddef>
+#include "LPT_PositionType.h"
 
 namespace PPlib
 {
@@ -27,20 +29,61 @@ namespace PPlib
 class ParticleData
 {
 public:
-    int StartPointID1;          //!< この粒子を放出した開始点のRank番号
-    int StartPointID2;          //!< この粒子を放出した開始点のID番号（同一プロセス内でのみ一意）
-    int ParticleID;             //!< 開始点から放出された順番を示す番号 (同一開始点内で一意)
-    REAL_TYPE x;                //!< 粒子のx座標
-    REAL_TYPE y;                //!< 粒子のy座標
-    REAL_TYPE z;                //!< 粒子のz座標
-    REAL_TYPE Vx;               //!< 粒子速度のx成分
-    REAL_TYPE Vy;               //!< 粒子速度のy成分
-    REAL_TYPE Vz;               //!< 粒子速度のz成分
-    double    StartTime;        //!< 粒子が放出された時刻
-    double    LifeTime;         //!< 粒子の寿命(放出された時刻からLiftime時間経過後に消滅する
-    long      BlockID;          //!< 粒子が存在する位置のブロックID
-    double    CurrentTime;      //!< どの時点の粒子データかを格納する
-    int       CurrentTimeStep;  //!< どの時点の粒子データかを格納する(タイムステップ)
+#ifdef PARTICLE_DATA_COMPACT
+    typedef float PARTICLE_TIME_TYPE;    //!< compactレイアウトでの放出時刻、寿命の型
+    typedef int   PARTICLE_BLOCKID_TYPE; //!< compactレイアウトでのブロックIDの型
+#else
+    typedef double PARTICLE_TIME_TYPE;
+    typedef long   PARTICLE_BLOCKID_TYPE;
+#endif
+    //メンバの並びはパディングが最小になるようにサイズの大きいものから順に並べている
+    PARTICLE_TIME_TYPE    StartTime;       //!< 粒子が放出された時刻
+    PARTICLE_TIME_TYPE    LifeTime;        //!< 粒子の寿命(放出された時刻からLiftime時間経過後に消滅する
+#ifndef PARTICLE_DATA_COMPACT
+    double                CurrentTime;     //!< どの時点の粒子データかを格納する
+#endif
+    PARTICLE_BLOCKID_TYPE BlockID;         //!< 粒子が存在する位置のブロックID
+    int                   StartPointID1;   //!< この粒子を放出した開始点のRank番号
+    int                   StartPointID2;   //!< この粒子を放出した開始点のID番号（同一プロセス内でのみ一意）
+    int                   ParticleID;      //!< 開始点から放出された順番を示す番号 (同一開始点内で一意)
+    int                   CurrentTimeStep; //!< どの時点の粒子データかを格納する(タイムステップ)
+    POSITION_TYPE         x;               //!< 粒子のx座標
+    POSITION_TYPE         y;               //!< 粒子のy座標
+    POSITION_TYPE         z;               //!< 粒子のz座標
+    REAL_TYPE             Vx;              //!< 粒子速度のx成分
+    REAL_TYPE             Vy;              //!< 粒子速度のy成分
+    REAL_TYPE             Vz;              //!< 粒子速度のz成分
+
+    //! 現在時刻を設定する
+    //
+    //! compactレイアウトでは時刻は保持せず、CurrentTimeStepのみで管理する
+    void SetCurrentTime(const double& Time)
+    {
+#ifndef PARTICLE_DATA_COMPACT
+        this->CurrentTime = Time;
+#endif
+    }
+
+    //! 現在時刻を返す
+    //
+    //! compactレイアウトでは時刻を保持していないので負の値を返す
+    double GetCurrentTime()
+    {
+#ifndef PARTICLE_DATA_COMPACT
+        return this->CurrentTime;
+#else
+        return -1.0;
+#endif
+    }
+
+    //! 粒子1個あたりのメモリ使用量(byte)の概算値を返す
+    //
+    //! ParticleData本体に加えて、ParticleContainerのlistのノード(前後のポインタと要素)の分を含む
+    //! mallocの管理領域は処理系依存なので含めていない
+    static size_t GetBytesPerParticle()
+    {
+        return sizeof(ParticleData)+2*sizeof(void*)+sizeof(ParticleData*);
+    }
 
     //! Getter
     //!  publicなメンバなので本来不要だが、LifeTime classへのインターフェースとして用意している
@@ -90,6 +133,10 @@ struct CompareBlockID
     {
         return (left->BlockID < right->BlockID) ? true : false;
     }
+    bool operator()(const ParticleData& left, const ParticleData& right) const
+    {
+        return (left.BlockID < right.BlockID) ? true : false;
+    }
 };
 
 //! 粒子をタイムステップ順にソートするためのファンクタ
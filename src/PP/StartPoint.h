@@ -17,6 +17,8 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <limits>
+#include <cstring>
 #include <Utility.h>
 
 namespace PPlib
@@ -24,6 +26,18 @@ namespace PPlib
 //forward declaration
 struct ParticleData;
 
+//! バイナリ形式の開始点データで開始点の種類を表す値
+enum StartPointType
+{
+    START_POINT_POINT = 1,
+    START_POINT_LINE,
+    START_POINT_RECTANGLE,
+    START_POINT_CUBOID,
+    START_POINT_CIRCLE,
+    START_POINT_MOVING_POINTS,
+    START_POINT_POINT_SET
+};
+
 //! @brief 開始点の情報を保持するクラス群の基底クラス
 //
 //! 全Rankが全てのインスタンスを1回生成し、データ分散の処理をした後で
@@ -54,6 +68,20 @@ public:
     //! 入力ストリームからTextPrintで返された形式の開始点情報を読み込む
     virtual void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime) = 0;
 
+    //! バイナリ形式で出力する時の開始点の種類を返す
+    virtual StartPointType GetType(void) const = 0;
+
+    //! @brief 開始点情報を無次元のままバイナリ形式でBufferの末尾に追加する
+    //!
+    //! 開始点の種類とデータ長はPPlib::PackStartPoints()が付加するので、ここでは各クラスのデータメンバのみを出力する
+    virtual void WriteBinary(std::string* Buffer) const = 0;
+
+    //! @brief WriteBinary()で出力された開始点情報を読み込む
+    //! @param Data [in] 読み込むデータの先頭
+    //! @param End  [in] 読み込むデータの末尾の次の位置
+    //! @return 読み込んだデータの次の位置 (データが不足している場合はNULL)
+    virtual const char* ReadBinary(const char* Data, const char* End) = 0;
+
     //! @brief 開始点を移動させる
     //! 基底クラスでは何もしない。
     //! 現時点ではMobingPointsのみがオーバーライドしている
@@ -76,6 +104,15 @@ public:
     //! CurrentTimeがこの開始点の寿命を越えている場合(すなわち StartTime+ReleaseTime < CurrentTime の時)Trueを返す
     bool CheckReleaseTime(const double& CurrentTime);
 
+    //! @brief この開始点から放出され、同時に存在する粒子数の推定値を返す
+    //!
+    //! 粒子が存在し続ける期間をParticleLifeTime, ReleaseTime, Horizonのうち正の値を持つものの最小値とし
+    //! その期間内の放出回数 x SumStartPoints を推定値とする
+    //! 計算領域から早く流出する粒子の影響は考慮しないので、実測値がある場合はそちらで補正すること
+    //! @param Horizon         [in] 寿命の指定が無い粒子が存在し続けると見做す期間
+    //! @param DefaultTimeSpan [in] TimeSpanが0以下(毎ステップ放出)の場合に代わりに用いる放出間隔
+    double EstimateNumResidentParticles(const double& Horizon, const double& DefaultTimeSpan) const;
+
     void SetID(int* ID)
     {
         for(int i = 0; i < 2; i++)
@@ -136,10 +173,30 @@ protected:
     //! @param Coord2    [in]  端点の座標その2
     void DividePoints(std::vector<REAL_TYPE>* Coords, const int& NumPoints, const REAL_TYPE Coord1[3], const REAL_TYPE Coord2[3]);
 
+    //! NumData個の値をバイナリのままBufferの末尾に追加する
+    template<typename T>
+    static void AppendBinary(std::string* Buffer, const T* Values, const size_t& NumData)
+    {
+        Buffer->append(reinterpret_cast<const char*>(Values), sizeof(T)*NumData);
+    }
+
+    //! @brief DataからNumData個の値を取り出してValuesに格納する
+    //! @return 取り出したデータの次の位置 (DataがNULLの場合とデータが不足している場合はNULL)
+    template<typename T>
+    static const char* ExtractBinary(const char* Data, const char* End, T* Values, const size_t& NumData)
+    {
+        if(Data == NULL || static_cast<size_t>(End-Data) < sizeof(T)*NumData)return NULL;
+        std::memcpy(Values, Data, sizeof(T)*NumData);
+        return Data+sizeof(T)*NumData;
+    }
+
+    //! TextPrint()で実数値を出力する時の桁数 (ReadText()で読み戻した値が元の値と一致するだけの桁数とする)
+    static int TextPrecision(void){return std::numeric_limits<double>::digits10+2;}
+
     //! @brief 時刻、ID関連のデータメンバを文字列に整形して返す
     //
     //以下のメンバの値を出力する
-    //StartTime, ReleaseTime, TimeSpan, LatestEmitTime, LatestEmitParticleID, ID
+    //StartTime, ReleaseTime, TimeSpan, LatestEmitTime, LatestEmitParticleID, ID, ParticleLifeTime
     std::string PrintTimeAndID(const double& RefTime) const;
 
     //! @brief 時刻、ID関連のデータメンバに指定されたinput streamから値を読み込む
@@ -147,6 +204,12 @@ protected:
     //値を読みとるメンバはPrintTimeAndIDと同じ
     void ReadTimeAndID(std::istream& stream, const double& RefTime);
 
+    //! PrintTimeAndID()と同じデータメンバをバイナリ形式でBufferの末尾に追加する
+    void WriteTimeAndIDBinary(std::string* Buffer) const;
+
+    //! WriteTimeAndIDBinary()で出力されたデータを読み込む
+    const char* ReadTimeAndIDBinary(const char* Data, const char* End);
+
     int SumStartPoints;              //!< 1つの設定で定義される開始点の数
                                      //!< インスタンス生成時に設定され、変更はしない
                                      //!< Point, MovingPointsの場合は必ず1
@@ -13,4 +13,5 @@
 #include "StartPointRectangle.h"
 #include "StartPointCuboid.h"
 #include "StartPointCircle.h"
-#include "StartPointMovingPoints.h"
\ No newline at end of file
+#include "StartPointMovingPoints.h"
+#include "StartPointPointSet.h"
\ No newline at end of file
@@ -35,6 +35,17 @@ public:
     //! TextPrintの出力を読み込む
     void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
 
+    StartPointType GetType(void) const
+    {
+        return START_POINT_CIRCLE;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
     //! 指定された開始点数からN, aの値を計算する
     bool Initialize(void);
 
@@ -35,6 +35,17 @@ public:
     //! TextPrintの出力を読み込む
     void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
 
+    StartPointType GetType(void) const
+    {
+        return START_POINT_CUBOID;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
     //! @brief 開始点オブジェクトをMaxNumStartPointsで指定した開始点数以下のオブジェクトに分割する
     //! 扇型に(中心角の方向のみ分割)し半径方向には分割しない
     //! @attention 分割前のオブジェクトは残っているので、このメソッド実行後に破棄すること
@@ -38,6 +38,17 @@ public:
     //! TextPrintの出力を読み込む
     void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
 
+    StartPointType GetType(void) const
+    {
+        return START_POINT_MOVING_POINTS;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
     //! 現在のタイムステップにおける開始点座標をCoordsから読み出して、Coord1にコピーする
     void UpdateStartPoint(double CurrentTime);
 
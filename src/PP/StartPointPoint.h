@@ -37,6 +37,17 @@ public:
     //! TextPrintの出力を読み込む
     void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
 
+    StartPointType GetType(void) const
+    {
+        return START_POINT_POINT;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
     //! @brief 開始点オブジェクトをMaxNumStartPointsで指定した開始点数以下のオブジェクトに分割する。
     //! 余りが生じた場合は1つ余計にオブジェクトを生成し、そのオブジェクトに余り領域を入れて返す
     //! @attention 分割前のオブジェクトは残っているので、このメソッド実行後に破棄すること
@@ -0,0 +1,83 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef PPLIB_POINT_SET_H
+#define PPLIB_POINT_SET_H
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <typeinfo>
+#include "StartPoint.h"
+
+namespace PPlib
+{
+//forward declaration
+class PointSet;
+PointSet* PointSetFactory(const int& NumPoints, const REAL_TYPE* Coords, double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
+//! @brief 任意の位置に並べた複数の点で定義された開始点の情報を保持するクラス
+//!
+//! 放出時刻や寿命が共通の多数の点を1つのオブジェクトで保持する
+//! Point型の開始点を点の数だけ定義した場合と同じ位置、タイミングで粒子を放出する
+class PointSet: public StartPoint
+{
+    PointSet() : StartPoint()
+    {
+        this->SumStartPoints = 0;
+    }
+
+public:
+    //! テキスト出力を行う
+    std::string TextPrint(const REAL_TYPE& RefLength, const double& RefTime) const;
+
+    //! TextPrintの出力を読み込む
+    void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
+
+    StartPointType GetType(void) const
+    {
+        return START_POINT_POINT_SET;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
+    //! @brief 開始点オブジェクトをMaxNumStartPointsで指定した開始点数以下のオブジェクトに分割する。
+    //! 先頭から順にMaxNumStartPoints個ずつの点に分け、余りが生じた場合は最後のオブジェクトに入れて返す
+    //! @attention 分割前のオブジェクトは残っているので、このメソッド実行後に破棄すること
+    //! @param MaxNumStartPoints [in]  分割後のオブジェクトが持つ最大の開始点数
+    //! @ret   分割後の開始点オブジェクトを格納したコンテナ
+    void Divider(std::vector<StartPoint*>* StartPoints, const int& MaxNumStartPoints);
+
+    //! @brief 格子点(粒子の発生位置)の座標を引数で指定したvectorに格納する
+    //! @param Coords [out] 格子点座標
+    void GetGridPointCoord(std::vector<REAL_TYPE>& Coords);
+
+private:
+    std::vector<REAL_TYPE> Coords; //!< 開始点座標 (x, y, zの順にSumStartPoints*3要素)
+
+    friend PointSet* PointSetFactory(const int& NumPoints, const REAL_TYPE* Coords, double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
+};
+static PointSet* PointSetFactory(const int& NumPoints, const REAL_TYPE* Coords, double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime)
+{
+    PointSet* tmpStartPoint = new PointSet;
+    if(Coords == NULL)return tmpStartPoint;
+
+    tmpStartPoint->Coords.assign(Coords, Coords+3*NumPoints);
+    tmpStartPoint->SumStartPoints   = NumPoints;
+    tmpStartPoint->StartTime        = StartTime;
+    tmpStartPoint->ReleaseTime      = ReleaseTime;
+    tmpStartPoint->TimeSpan         = TimeSpan;
+    tmpStartPoint->ParticleLifeTime = ParticleLifeTime;
+    return tmpStartPoint;
+}
+} // namespace PPlib
+#endif
@@ -35,6 +35,17 @@ public:
     //! TextPrintの出力を読み込む
     void ReadText(std::istream& stream, const REAL_TYPE& RefLength, const double& RefTime);
 
+    StartPointType GetType(void) const
+    {
+        return START_POINT_RECTANGLE;
+    }
+
+    //! バイナリ形式で出力する
+    void WriteBinary(std::string* Buffer) const;
+
+    //! WriteBinaryの出力を読み込む
+    const char* ReadBinary(const char* Data, const char* End);
+
     //! @brief 開始点オブジェクトをMaxNumStartPointsで指定した開始点数以下のオブジェクトに分割する
     //! NxM行列をNB, MBで2次元のブロック分割(余りあり)するようなイメージで
     //! 矩形領域をNBxMBの小領域+余り領域に分割する
@@ -75,6 +86,12 @@ private:
     //! @param NumPoints2 [out] Coord1とCoord4の間の格子点数
     void MakeCoord3_4(REAL_TYPE Coord3[3], int* NumPoints1, REAL_TYPE Coord4[3], int* NumPoints2);
 
+    //! @brief 面の法線方向をNormalで指定してMakeCoord3_4()と同じ処理を行なう
+    void MakeCoord3_4(const int& Normal, REAL_TYPE Coord3[3], int* NumPoints1, REAL_TYPE Coord4[3], int* NumPoints2);
+
+    //! Coord1とCoord2の座標が一致する方向(面の法線方向 x=0, y=1, z=2)を返す
+    int GetNormalAxis(void) const;
+
     friend Rectangle* RectangleFactory(REAL_TYPE Coord1[3], REAL_TYPE Coord2[3], int NumStartPoints[3], double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime);
 };
 static Rectangle* RectangleFactory(REAL_TYPE Coord1[3], REAL_TYPE Coord2[3], int NumStartPoints[3], double StartTime, double ReleaseTime, double TimeSpan, double ParticleLifeTime)
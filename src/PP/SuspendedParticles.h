@@ -0,0 +1,122 @@
+/*
+ * LPTlib
+ * Lagrangian Particle Tracking library
+ *
+ * Copyright (c) 2012-2014 Advanced Institute for Computational Science, RIKEN.
+ * All rights reserved.
+ *
+ */
+
+#ifndef PPLIB_SUSPENDED_PARTICLES_H
+#define PPLIB_SUSPENDED_PARTICLES_H
+#include <map>
+#include <vector>
+#include <omp.h>
+#include "LPT_PositionType.h"
+
+namespace PPlib
+{
+//forward declaration
+class ParticleData;
+
+//! @brief サブステップの途中で未着のデータブロックへ移動したため計算を中断した粒子の状態
+//!
+//! 中断中の粒子オブジェクトは更新されない(座標、時刻、BlockIDは移動前のまま)
+//! タイムステップの終わりまで再開できなかった粒子は、PP_Transport::Finish()で中断した時点の座標まで移動させる
+struct SuspendedParticle
+{
+    ParticleData* Particle;  //!< 計算を中断した粒子
+    POSITION_TYPE Coord[3];  //!< 中断した時点の粒子座標
+    long BlockID;            //!< 計算を再開するデータブロックのID
+    int t;                   //!< 次に計算するサブステップ
+    int numT;                //!< サブステップ数
+    double dt;               //!< サブステップの時間刻み
+};
+
+//! @brief 計算を中断した粒子を、再開するデータブロック毎に保持するキュー
+class SuspendedParticles
+{
+    //non copyable
+    SuspendedParticles(const SuspendedParticles& obj);
+    SuspendedParticles& operator=(const SuspendedParticles& obj);
+
+public:
+    SuspendedParticles() : NumParticles(0)
+    {
+        omp_init_lock(&SuspendedParticlesLock);
+    }
+
+    //! 粒子オブジェクトはdeleteしないので、呼び出し側で空にしておくこと
+    ~SuspendedParticles()
+    {
+        for(std::map<long, std::vector<SuspendedParticle>*>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            delete it->second;
+        }
+        omp_destroy_lock(&SuspendedParticlesLock);
+    }
+
+    //! 中断した粒子を再開先のBlockIDのエントリに追加する
+    void push(const SuspendedParticle& State)
+    {
+        omp_set_lock(&SuspendedParticlesLock);
+        std::vector<SuspendedParticle>*& list = table[State.BlockID];
+        if(list == NULL)
+        {
+            list = new std::vector<SuspendedParticle>;
+        }
+        list->push_back(State);
+        ++NumParticles;
+        omp_unset_lock(&SuspendedParticlesLock);
+    }
+
+    //! 指定されたBlockIDで再開する粒子のリストを返す
+    //
+    //! ここで渡したリストはキューから削除されるので、呼び出し側でdeleteすること
+    //! 該当する粒子が無い時はNULLを返す
+    std::vector<SuspendedParticle>* find(const long& BlockID)
+    {
+        std::vector<SuspendedParticle>* rt = NULL;
+        omp_set_lock(&SuspendedParticlesLock);
+        std::map<long, std::vector<SuspendedParticle>*>::iterator it = table.find(BlockID);
+        if(it != table.end())
+        {
+            rt            = it->second;
+            NumParticles -= rt->size();
+            table.erase(it);
+        }
+        omp_unset_lock(&SuspendedParticlesLock);
+        return rt;
+    }
+
+    //! 中断した粒子が登録されているBlockIDの一覧を返す
+    void GetBlockIDs(std::vector<long>* BlockIDs)
+    {
+        omp_set_lock(&SuspendedParticlesLock);
+        BlockIDs->clear();
+        BlockIDs->reserve(table.size());
+        for(std::map<long, std::vector<SuspendedParticle>*>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            BlockIDs->push_back(it->first);
+        }
+        omp_unset_lock(&SuspendedParticlesLock);
+    }
+
+    //! キューに登録されている粒子数を返す
+    size_t size(void)
+    {
+        return NumParticles;
+    }
+
+private:
+    //再開するブロックIDとそのブロックで再開する粒子の状態を保持するテーブル
+    std::map<long, std::vector<SuspendedParticle>*> table;
+
+    //キューに登録されている粒子の総数
+    size_t NumParticles;
+
+    // SuspendedParticlesの操作に関わるロック変数
+    omp_lock_t SuspendedParticlesLock;
+};
+} // namespace PPlib
+#endif
@@ -35,6 +35,11 @@ public:
     //
     //余りは許容し、NBxMBxKB<MaxPoints となるように適当に調整する
     static void DetermineBlockSize(int* arg_NB, int* arg_MB, int* arg_KB, const int& MaxPoints, const int& N, const int& M, const int& K);
+
+    //! セルのindex(i,j,k)のビットを交互に並べたMorton(Z-order)符号を返す
+    //
+    //! 各方向の下位21bitのみを使う (unsigned longが64bitの環境を前提とする)
+    static unsigned long MortonKey(const unsigned int& i, const unsigned int& j, const unsigned int& k);
 };
 } // namespace PPlib
 #endif
\ No newline at end of file